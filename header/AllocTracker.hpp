@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Opt-in heap allocation counting. Built with -DALLOC_TRACKING=1 (make
+// ALLOC_TRACKING=1 after a clean) the global operator new and delete are
+// replaced by versions that count calls and bytes per thread; otherwise
+// nothing is hooked and every count stays 0.
+//
+// The main thread brackets each frame with beginFrame / endFrame, and once
+// the first WARMUP_FRAMES are over (reused buffers have grown by then) the
+// per frame counts are summed up for printSummary. With sampling on, the
+// call stack of every Nth allocation on each thread after the warmup is kept
+// to show where the allocations come from.
+//
+// Chunk streaming is checked the same way: what Game::UpdateChunks
+// allocates on the main thread, everything the other threads (mesh jobs,
+// horizon tiles) allocate, and the glGen* / glDelete* calls, which
+// hookGlObjectCalls counts by wrapping glad's function pointers.
+#ifndef ALLOC_TRACKING
+#define ALLOC_TRACKING 0
+#endif
+
+class AllocTracker {
+    public:
+        static const size_t MAX_THREADS = 64;         // later threads share the last slot
+        static const size_t MAX_SAMPLED_SITES = 256;
+        static const int SAMPLE_DEPTH = 12;           // frames per sampled call stack
+        static const uint64_t WARMUP_FRAMES = 120;
+
+        struct Counts {
+            uint64_t allocations = 0;
+            uint64_t bytes = 0;
+
+            Counts operator-(const Counts& other) const { return {allocations - other.allocations, bytes - other.bytes}; }
+        };
+
+        static bool enabled() { return ALLOC_TRACKING != 0; }
+        // Since the start of the program
+        static Counts thisThread();
+        static Counts allThreads();
+
+        // Records every Nth allocation's call stack on each thread, 0 = off
+        static void setSampleInterval(uint32_t interval);
+
+        // Main thread, after glad is loaded. Does nothing without ALLOC_TRACKING.
+        static void hookGlObjectCalls();
+
+        // Main thread. render is what Game::Render allocated this frame,
+        // streaming what Game::UpdateChunks did.
+        static void beginFrame();
+        static void endFrame(const Counts& render, const Counts& streaming);
+        // After the warmup: allocations made by Game::Render, by
+        // Game::UpdateChunks and every other thread, and glGen/glDelete calls
+        static uint64_t steadyRenderAllocations();
+        static uint64_t steadyStreamingAllocations();
+        static uint64_t steadyGlObjectCalls();
+
+        // Per frame figures, per thread totals and the most sampled call sites
+        static void printSummary();
+};
@@ -1,6 +1,7 @@
 #pragma once
 #ifndef BLOCKTYPE_HPP
 #define BLOCKTYPE_HPP
+#include <cstdint>
 #include <unordered_map>
 #include <glm/glm.hpp>
 #include <stdio.h>
@@ -16,7 +17,8 @@ enum Face {
 
 
 
-enum class BlockType { Air, Grass, Wood, GrassSide, Stone, Dirt, Sand, WoodSide, GrassTop, WoodTop , Sandstone, Leaves};
+// One byte each, chunks hold 16^3 of them
+enum class BlockType : uint8_t { Air, Grass, Wood, GrassSide, Stone, Dirt, Sand, WoodSide, GrassTop, WoodTop , Sandstone, Leaves};
 
 static std::unordered_map<BlockType, glm::vec2> blockTypeToTextureCoords = {
     {BlockType::GrassSide, {3,0}},
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include "RecyclingAllocator.hpp"
+
+// Bookkeeping for ranges inside one big GPU buffer, in whatever unit the
+// owner picks (vertex pages, indices, ...). First-fit over an address
+// ordered free list; neighbouring free blocks are merged on free. The free
+// list's nodes are recycled, so a warmed up allocator doesn't touch the heap;
+// use it from one thread.
+class BufferSubAllocator {
+    public:
+        static const uint32_t INVALID_OFFSET = UINT32_MAX;
+
+        BufferSubAllocator(uint32_t capacity = 0);
+
+        void reset(uint32_t capacity);
+        // Adds free space at the end, keeping every allocation where it is
+        void grow(uint32_t capacity);
+        uint32_t allocate(uint32_t size);   // INVALID_OFFSET if nothing fits
+        void free(uint32_t offset, uint32_t size);
+        // Shrinks a block or grows it into free space right after it. Returns
+        // false (and changes nothing) when it can't grow without moving.
+        bool resize(uint32_t offset, uint32_t oldSize, uint32_t newSize);
+
+        uint32_t capacity() const { return totalCapacity; }
+        uint32_t freeUnits() const { return freeTotal; }
+        uint32_t usedUnits() const { return totalCapacity - freeTotal; }
+        uint32_t largestFreeBlock() const;
+        size_t freeBlockCount() const { return freeBlocks.size(); }
+        // 0 when all free space is one block, approaching 1 when it is scattered
+        float fragmentation() const;
+        // Warms the (shared, per thread) node free list for this many free
+        // blocks, there are at most one more than live allocations
+        static void reserveBlocks(size_t count);
+
+    private:
+        typedef std::map<uint32_t, uint32_t, std::less<uint32_t>, RecyclingAllocator<std::pair<const uint32_t, uint32_t>>> FreeBlockMap;
+        FreeBlockMap freeBlocks;   // offset -> size
+        uint32_t totalCapacity = 0;
+        uint32_t freeTotal = 0;
+};
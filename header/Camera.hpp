@@ -20,6 +20,10 @@ class Camera {
         glm::mat4 getViewMatrix();
         void processMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
         void updateCameraVectors();
+        // Jumps straight to a pose, angles in degrees like the mouse look (scripted flights)
+        void setPose(const glm::vec3& position, float yaw, float pitch);
+        float getYaw() const { return Yaw; }
+        float getPitch() const { return Pitch; }
         void processMouseScroll(float yoffset);
         glm::vec3 cameraPos; // current position of the camera
         glm::vec3 cameraTarget; // where the camera is looking at
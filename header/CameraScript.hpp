@@ -0,0 +1,45 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A camera flight for benchmark runs: keyframes of position and look angles
+// that the camera is moved through linearly, so every run sees the same
+// frames no matter how fast they render.
+//
+// Script files have one keyframe per line, "time x y z yaw pitch" with time
+// in seconds and angles in degrees; '#' starts a comment. Past the last
+// keyframe the flight starts over. A "seed N" line names the world the path
+// was recorded in, so a replay flies over the same terrain.
+class CameraScript {
+    public:
+        struct Keyframe {
+            float time;
+            glm::vec3 position;
+            float yaw;
+            float pitch;
+        };
+
+        // Starts with the built-in flyover
+        CameraScript();
+
+        bool load(const std::string& path);
+        bool save(const std::string& path) const;
+        // A square loop above the terrain around the spawn
+        void useDefaultFlight();
+
+        // Recording: keyframes have to come in time order
+        void clear() { keyframes.clear(); }
+        void addKeyframe(float time, const glm::vec3& position, float yaw, float pitch);
+
+        void sample(float time, glm::vec3& position, float& yaw, float& pitch) const;
+        float duration() const { return keyframes.empty() ? 0.0f : keyframes.back().time; }
+        size_t keyframeCount() const { return keyframes.size(); }
+        uint32_t seed() const { return worldSeed; }
+        void setSeed(uint32_t seed) { worldSeed = seed; }
+
+    private:
+        std::vector<Keyframe> keyframes;   // sorted by time
+        uint32_t worldSeed;
+};
@@ -11,6 +11,13 @@
 #include "TexureManager.hpp"
 #include "BlockType.hpp"
 #include "Biome.hpp"
+#include "StagingRing.hpp"
+#include "MeshData.hpp"
+#include "RenderQueue.hpp"
+#include "ChunkMeshArena.hpp"
+#include "FaceArena.hpp"
+#include "MemoryStats.hpp"
+#include "ChunkLifecycle.hpp"
 
 
 
@@ -33,11 +40,22 @@ class Game;
 
 class Chunk {
 public:
-    Chunk(int sizeX, int sizeY, int sizeZ, glm::vec3 position, Game *gameRef, GLuint shaderProgram, TextureManager& textureManager);
+    Chunk(int sizeX, int sizeY, int sizeZ, glm::vec3 position, Game *gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel = 0);
+    // Empty, with the storage a chunk at lodLevel needs, for ChunkPool::reserve; reset() generates it
+    Chunk(int sizeX, int sizeY, int sizeZ, Game *gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel);
     ~Chunk();
+    // Re-generates a pooled chunk at a new position, keeping its storage
+    void reset(glm::vec3 position, int lodLevel = 0);
+    // 0 is full detail, level n is meshed from a 2^n times coarser grid (see ChunkLod.hpp)
+    int lodLevel;
+    // What the mesher writes and which arena the mesh goes to. Set once at
+    // startup, before the first chunk is meshed.
+    static MeshFormat meshFormat;
     TextureManager& textureManager;
     void randomlyRemoveVoxels();
-    void render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection);
+    // Queues the mesh minus the face directions that can't face the camera,
+    // returns the number of triangles queued
+    size_t submit(RenderQueue& queue, GLuint atlasTexture, const glm::vec3& cameraPos);
     void generateChunk();
     void initChunk();
     std::vector<int> tintFlagsArray;
@@ -52,21 +70,60 @@ public:
     void placeTree(int x, int y, int z);
 
     bool isVoxelSolid(int x, int y, int z) ;
+    // Full resolution blocks, level 0 chunks only. A coarser chunk generates
+    // into its worker's grid and keeps just lodCells (empty voxels).
     std::vector<std::vector<std::vector<BlockType>>> voxels;
+    // The downsampled grid a level > 0 chunk was meshed from, (x * ny + y) * nz + z
+    std::vector<BlockType> lodCells;
     void setupMesh();
+    size_t meshByteSize() const;
+    // Bytes this chunk holds, for MemoryStats
+    ChunkMemory memoryUsage() const;
+    size_t meshTriangleCount() const { return mesh != nullptr ? mesh->triangleCount() : meshVertexFloats / 12 * 2 + meshFaceCount * 2; }
+    // World space bounds of the mesh (voxels are centered on integer coordinates)
+    glm::vec3 boundsMin() const { return position - glm::vec3(0.5f); }
+    glm::vec3 boundsMax() const { return position + glm::vec3(sizeX, sizeY, sizeZ) - glm::vec3(0.5f); }
+    // Worker side: move the finished mesh off this thread's scratch buffers,
+    // into the staging ring so setupMesh only has to issue GPU copies, or into
+    // the chunk's own storage if the ring is full (returns false then).
+    bool stageMesh(StagingRing& ring);
+    void releaseStagedMesh();
+    // GL thread: gives the chunk's space in the mesh (or face) arena back
+    void releaseMesh();
+    // World space boxes (min, max pairs) that are completely solid, used as
+    // occluders. Rebuilt with the mesh.
+    std::vector<glm::vec3> occluderBoxes;
+    // Bit a * 6 + b is set when air inside the chunk connects face a to face
+    // b (Face enum order). Rebuilt with the mesh, all set until then.
+    uint64_t faceConnections = ~0ull;
+    bool facesConnected(Face a, Face b) const { return (faceConnections >> (a * 6 + b)) & 1; }
+    unsigned int visibleFrame = 0;  // last frame the frustum culler kept this chunk
+    ChunkTrace trace;               // lifecycle timestamps, cleared by reset
 
 
 
 
 private:
-    unsigned int VAO, VBO, EBO, CBO, TBO;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<float> texCoordsArray;
+    friend class ChunkBenchmarkAccess;   // the microbenchmarks time private mesher steps
+    ChunkMeshArena::Handle meshHandle = 0;   // a FaceArena::Handle with MeshFormat::FaceRecords
+    MeshData* mesh = nullptr;      // latest mesh not yet uploaded (thread scratch or ownedMesh)
+    MeshData ownedMesh;
+    size_t meshVertexFloats = 0, meshTexCoordFloats = 0, meshFaceCount = 0;
+    uint32_t meshDirectionQuads[6] = {};   // of the uploaded mesh, see MeshData::directionQuads
     GLuint textureID;
+    StagingRing* stagingRing = nullptr;
+    StagingRing::Region stagedMesh;
 
     std::vector<float> colors;
     void addFace(const glm::vec3& pos, Face face);
+    void addQuad(const glm::vec3& lo, const glm::vec3& hi, Face face, BlockType blockType);
+    void submitQuads(RenderQueue& queue, GLuint atlasTexture, uint32_t firstQuad, uint32_t quadCount);
+    void allocateStorage();
+    void build();   // initChunk + generateChunk, on borrowed voxels for a coarse chunk
+    void allocateVoxels(std::vector<std::vector<std::vector<BlockType>>>& grid) const;
+    void generateLodMesh(int step);
+    void computeOccluders();
+    void computeConnectivity();
     Chunk* getLeftNeighbor();
     Chunk* getRightNeighbor();
     Chunk* getFrontNeighbor();
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "LatencyHistogram.hpp"
+
+// The steps of a chunk's trip from being wanted to leaving again, in order
+enum class ChunkStage {
+    Requested,    // UpdateChunks queued the job
+    Started,      // a worker picked it up
+    Generated,    // terrain filled in (initChunk)
+    Meshed,       // generateChunk done
+    Queued,       // staged and pushed onto chunksToAdd
+    Uploaded,     // setupMesh ran on the GL thread
+    FirstDrawn,   // first frame that submitted it
+    Unloaded,     // retired: out of range, replaced by another level of detail, or discarded before upload
+    Count
+};
+
+// When one chunk reached each stage, in FrameStats::nowSeconds, 0 = not yet
+struct ChunkTrace {
+    static const int STAGES = static_cast<int>(ChunkStage::Count);
+
+    int x = 0, z = 0, lod = 0;   // in chunks
+    bool remesh = false;         // replaces a loaded chunk at another level of detail
+    double at[STAGES] = {};
+
+    void stamp(ChunkStage stage, double seconds) { at[static_cast<int>(stage)] = seconds; }
+    bool reached(ChunkStage stage) const { return at[static_cast<int>(stage)] > 0.0; }
+    // Time spent getting to stage from the one before it, 0 if either is missing
+    double stageSeconds(ChunkStage stage) const;
+};
+
+// Per stage latency distributions over every traced chunk, and the full
+// trace of the slow ones: a chunk whose request to upload time goes over
+// the threshold is logged with its breakdown and kept for writeJson.
+// Main thread only.
+class ChunkLifecycle {
+    public:
+        static constexpr double DEFAULT_SLOW_MILLIS = 500.0;
+        static const size_t MAX_SLOW_TRACES = 256;   // the most recent are kept
+
+        static const char* name(ChunkStage stage);
+        static void setSlowThreshold(double millis);   // 0 = don't log or keep any
+
+        // Call once the trace has reached the stage
+        static void uploaded(const ChunkTrace& trace);
+        static void drawn(const ChunkTrace& trace);
+        static void unloaded(const ChunkTrace& trace);
+
+        // Time from the previous stage into this one
+        static const LatencyHistogram& stageHistogram(ChunkStage stage);
+
+        static void printSummary();
+        // Distributions and the slow chunk traces
+        static bool writeJson(const std::string& path);
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <algorithm>
+
+// Level of detail rings around the player, in chunks (Chebyshev distance).
+// Level n meshes the chunk from a grid downsampled 2^n times per axis.
+// Full detail only right around the player: at the default distance of 12
+// this keeps the triangles and memory (--bench-lod 12) under what distance
+// 3 took at full detail.
+#define LOD_LEVELS 4
+static const int LOD_RING_END[LOD_LEVELS - 1] = {2, 8, 16};   // level 0 below 2, 1 below 8, 2 below 16, 3 beyond
+
+inline int lodForDistance(int distance) {
+    int level = 0;
+    while (level < LOD_LEVELS - 1 && distance >= LOD_RING_END[level]) {
+        level++;
+    }
+    return level;
+}
+
+// Keeps a loaded chunk at its current level until it is a full chunk past
+// the ring boundary, so walking along a boundary doesn't remesh back and forth
+inline int chooseLod(int distance, int currentLevel) {
+    if (currentLevel >= 0 && currentLevel >= lodForDistance(std::max(0, distance - 1))
+                          && currentLevel <= lodForDistance(distance + 1)) {
+        return currentLevel;
+    }
+    return lodForDistance(distance);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "PagedArena.hpp"
+#include "StagingRing.hpp"
+
+// All chunk meshes live in a few shared buffers (positions, texture
+// coordinates) behind one VAO, so the visible set can be drawn with a single
+// multi-draw.
+//
+// Every mesh is a list of quads, 4 vertices each, so chunks don't store
+// indices at all: one static buffer of 16 bit indices holds {0,1,2,2,3,0} +
+// 4 * quad for as many quads as the biggest chunk can have, and each draw
+// uses the front of it with its own base vertex. A range of more quads than
+// 16 bits can count is drawn in several pieces of QUADS_PER_DRAW.
+//
+// Vertices are handed out in pages of ARENA_PAGE_VERTICES. A buffer texture
+// holds each page's chunk offset, and the vertex shader finds it with
+// gl_VertexID / ARENA_PAGE_VERTICES (gl_VertexID includes the base vertex).
+// That works the same for glMultiDrawElementsIndirect and for the GL 3.3
+// glMultiDrawElementsBaseVertex path, without per-draw uniforms. Handing out
+// pages and compacting them is PagedArena's.
+class ChunkMeshArena : public PagedArena {
+    public:
+        static const uint32_t ARENA_PAGE_VERTICES = 1024;   // keep in sync with VertShader
+        static constexpr uint32_t QUADS_PER_DRAW = 65536 / 4;   // as many as GL_UNSIGNED_SHORT indices reach
+
+        enum class Stream { Positions, TexCoords };
+
+        struct DrawRange {
+            GLsizei indexCount;
+            GLuint firstIndex;   // always 0, every chunk starts at the front of the quad indices
+            GLint baseVertex;
+        };
+
+        ChunkMeshArena();
+        ~ChunkMeshArena();
+
+        // GL thread only from here on
+        // maxQuadsPerMesh sizes the shared index buffer (up to QUADS_PER_DRAW)
+        bool init(uint32_t pageCount, uint32_t maxQuadsPerMesh);
+        void shutdown();
+
+        // allocate and reallocate take a vertex count
+        void write(Handle handle, Stream stream, const void* data, size_t bytes);
+        void copyFromStaging(Handle handle, Stream stream, StagingRing& ring, const StagingRing::Region& region, size_t srcOffset, size_t bytes);
+        // Quads firstQuad .. firstQuad + quadCount - 1 of the mesh, quadCount at most QUADS_PER_DRAW
+        DrawRange drawRange(Handle handle, uint32_t firstQuad, uint32_t quadCount) const;
+
+        GLuint vao() const { return arenaVAO; }
+        GLuint pageTableTexture() const { return pageTableTex; }
+
+        Stats stats() const;   // bytesReserved includes the quad indices
+
+    protected:
+        void movePages(uint32_t fromPage, uint32_t toPage, uint32_t pageCount) override;
+        void growBuffers(uint32_t pageCount) override;
+        void writePageTable(const Allocation& allocation) override;
+
+    private:
+        GLuint arenaVAO = 0;
+        GLuint positionBuffer = 0, texCoordBuffer = 0;
+        GLuint quadIndexBuffer = 0;
+        uint32_t quadIndexCount = 0;   // quads the shared index buffer covers
+        GLuint pageTableBuffer = 0, pageTableTex = 0;
+        std::vector<glm::vec4> pageOffsets;    // CPU copy of the page table
+
+        void createBuffers(uint32_t pageCount, GLuint& positions, GLuint& texCoords, GLuint& pageTable);
+        void createQuadIndices(uint32_t quads);
+        void bindVertexLayout();
+        GLuint bufferFor(Stream stream) const;
+        size_t byteOffset(const Allocation& allocation, Stream stream) const;
+};
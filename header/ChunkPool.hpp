@@ -0,0 +1,42 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <vector>
+
+class Chunk;
+class Game;
+class TextureManager;
+
+// Recycles unloaded chunks instead of freeing them. A pooled chunk keeps its
+// voxel arrays and its fallback mesh storage, so streaming chunks in and out
+// at a steady rate does no new/delete. Its mesh goes back to the arena.
+// Level 0 chunks (full voxels) and coarser ones (only cells) are pooled
+// apart, so each level gets back a chunk with the storage it needs.
+class ChunkPool {
+    public:
+        ChunkPool(size_t maxPooled = 256);
+        ~ChunkPool();
+
+        // Any thread. Reuses a pooled chunk when there is one, otherwise
+        // builds a new one; either way the chunk comes back generated and meshed.
+        Chunk* acquire(int sizeX, int sizeY, int sizeZ, glm::vec3 position, Game* gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel = 0);
+        // Pools this many empty level 0 and coarse chunks up front (and keeps
+        // room for that many), so streaming a steady view never builds one
+        void reserve(size_t fullCount, size_t coarseCount, int sizeX, int sizeY, int sizeZ, Game* gameRef, GLuint shaderProgram, TextureManager& textureManager);
+        // GL thread (the chunk is deleted if the pool is full)
+        void release(Chunk* chunk);
+        // GL thread, frees everything that is pooled
+        void clear();
+
+        size_t pooledCount() const;
+        size_t pooledBytes() const;
+        size_t createdCount() const { return created; }
+
+    private:
+        std::vector<Chunk*> freeChunks;     // level 0, with voxels
+        std::vector<Chunk*> coarseChunks;   // level > 0, cells only
+        size_t maxPooled;
+        size_t created = 0;
+        mutable std::mutex mutex;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Frustum.hpp"
+#include "Game.hpp"
+
+class Chunk;
+
+// Cave culling: a breadth first walk over chunk cells starting at the
+// camera's, crossing from one chunk into the next only through faces that
+// are linked by air inside the chunk (Chunk::faceConnections), only away
+// from the camera (never back against a direction already taken) and only
+// into cells the frustum culler kept. Chunks in sealed off pockets are
+// never reached.
+//
+// Cells without a loaded chunk (not generated yet, or the sky above the
+// one layer of chunks) are treated as open air.
+class ChunkVisibility {
+    public:
+        ChunkVisibility(int chunkSize);
+
+        // Appends the reachable loaded chunks to visible. Chunks the frustum
+        // culler kept this frame must have visibleFrame == frame.
+        void collect(const ChunkMap& loadedChunks, const glm::vec3& cameraPos, const Frustum& frustum,
+                     unsigned int frame, int radius, std::vector<Chunk*>& visible);
+
+        size_t visitedCells() const { return visited; }
+        // Sizes the walk for radius, with the camera below the sky layer
+        void reserve(int radius);
+
+    private:
+        struct Node {
+            glm::ivec3 cell;
+            int8_t entryFace;      // face of this cell we came in through, -1 at the camera
+            uint8_t directions;    // faces stepped out through on the way here
+        };
+
+        int chunkSize;
+        std::vector<Node> queue;
+        std::vector<uint8_t> seen;
+        size_t visited = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class Chunk;
+
+// Epoch based reclamation for chunks.
+// Worker jobs that may touch chunks (their own or a neighbor found through
+// loadedChunks) hold an EpochGuard for the duration of the job. The main
+// thread unlinks a chunk from loadedChunks and then retires it; the chunk is
+// only deleted once every job that was running at retire time has finished.
+class EpochManager {
+    public:
+        EpochManager(size_t maxThreads = 64);
+        ~EpochManager();
+
+        void enter();
+        void exit();
+
+        // Main thread only
+        // What happens to a chunk once it is safe, deleting it by default
+        void setReclaimer(std::function<void(Chunk*)> reclaimer);
+        // Room for this many retired chunks, so retire doesn't allocate
+        void reserve(size_t chunks);
+        void retire(Chunk* chunk);
+        size_t reclaim(size_t maxChunks);
+        size_t reclaimAll();
+        size_t pendingCount() const;
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<bool> claimed{false};
+            std::atomic<uint64_t> epoch{0};   // 0 = not inside a guard
+            int depth = 0;
+        };
+        struct Retired {
+            Chunk* chunk;
+            uint64_t epoch;
+        };
+
+        std::atomic<uint64_t> globalEpoch;
+        std::vector<Slot> slots;
+        std::vector<Retired> retired;
+        std::vector<Chunk*> reclaimable;
+        std::function<void(Chunk*)> reclaimer;
+        mutable std::mutex retiredMutex;
+
+        Slot& localSlot();
+        uint64_t oldestActiveEpoch() const;
+};
+
+class EpochGuard {
+    public:
+        explicit EpochGuard(EpochManager& manager) : manager(manager) { manager.enter(); }
+        ~EpochGuard() { manager.exit(); }
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    private:
+        EpochManager& manager;
+};
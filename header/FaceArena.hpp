@@ -0,0 +1,61 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "MeshData.hpp"
+#include "PagedArena.hpp"
+#include "StagingRing.hpp"
+
+// Vertex pulling counterpart of ChunkMeshArena: every chunk's FaceRecords
+// live in one buffer, read by the vertex shader through a GL_RG32UI buffer
+// texture. There are no vertex attributes or indices; a face is drawn as 6
+// vertices of glMultiDrawArrays and VertShaderFaces turns gl_VertexID / 6
+// into the record to expand.
+//
+// Records are handed out in pages of FACE_PAGE_RECORDS (by PagedArena) and,
+// like the mesh arena, a page table buffer texture holds each page's chunk
+// offset.
+class FaceArena : public PagedArena {
+    public:
+        static const uint32_t FACE_PAGE_RECORDS = 256;   // keep in sync with VertShaderFaces
+        static const uint32_t VERTICES_PER_FACE = 6;
+
+        struct DrawRange {
+            GLint firstVertex;
+            GLsizei vertexCount;
+        };
+
+        FaceArena();
+        ~FaceArena();
+
+        // GL thread only from here on
+        bool init(uint32_t pages);
+        void shutdown();
+
+        // allocate and reallocate take a face count
+        void write(Handle handle, const void* data, size_t bytes);
+        void copyFromStaging(Handle handle, StagingRing& ring, const StagingRing::Region& region, size_t srcOffset, size_t bytes);
+        // Faces firstFace .. firstFace + faceCount - 1 of the mesh
+        DrawRange drawRange(Handle handle, uint32_t firstFace, uint32_t faceCount) const;
+
+        GLuint vao() const { return emptyVAO; }
+        GLuint recordTexture() const { return recordTex; }
+        GLuint pageTableTexture() const { return pageTableTex; }
+
+        Stats stats() const;
+
+    protected:
+        void movePages(uint32_t fromPage, uint32_t toPage, uint32_t pageCount) override;
+        void growBuffers(uint32_t pageCount) override;
+        void writePageTable(const Allocation& allocation) override;
+
+    private:
+        GLuint emptyVAO = 0;   // core profile needs one bound even without attributes
+        GLuint recordBuffer = 0, recordTex = 0;
+        GLuint pageTableBuffer = 0, pageTableTex = 0;
+        std::vector<glm::vec4> pageOffsets;    // CPU copy of the page table
+
+        void createBuffers(uint32_t pageCount, GLuint& records, GLuint& pageTable);
+        void attachTextures();
+};
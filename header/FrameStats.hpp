@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "LatencyHistogram.hpp"
+
+// Rolling window of frame times used to report percentiles (p99 hitches are
+// what players notice during fast flight, the average hides them).
+class FrameStats {
+    public:
+        FrameStats(size_t windowSize = 600);
+
+        void beginFrame();
+        void endFrame();
+        void addUploads(size_t chunks, size_t bytes);
+        void addCulling(size_t drawn, size_t culled);
+        void addOcclusion(size_t occluded);
+        void addCaveCulling(size_t unreachable);
+        void addHorizon(size_t tiles, size_t triangles);
+        void addChunkTriangles(size_t submitted, size_t facingAway);
+        void addDrawCalls(size_t calls);
+        void addLoadedChunks(size_t loaded);
+        // Chunks meshed by the workers and ones thrown away before upload
+        void addStreaming(size_t generated, size_t discarded);
+        // From the chunk being queued to the first frame that draws it
+        void addChunkLoadLatency(float millis);
+        void setMeshMemory(size_t bytesInUse, size_t bytesReserved, float fragmentation);
+
+        float percentile(float p) const;   // milliseconds, p in [0, 100]
+        static float percentile(std::vector<float> values, float p);
+        float maxFrameMillis() const;
+        size_t sampleCount() const { return count; }
+
+        // Prints the current window to stdout every intervalSeconds
+        void report(float intervalSeconds = 5.0f);
+        // Everything gathered since the last report, for the end of a scripted run
+        void summary();
+
+        static double nowSeconds();
+
+    private:
+        std::vector<float> frameMillis;
+        size_t next = 0;
+        size_t count = 0;
+        double frameStart = 0.0;
+        double lastReport = 0.0;
+        size_t uploadedChunks = 0;
+        size_t uploadedBytes = 0;
+        size_t drawnChunks = 0;
+        size_t culledChunks = 0;
+        size_t culledFrames = 0;
+        size_t occludedChunks = 0;
+        size_t unreachableChunks = 0;
+        size_t horizonTiles = 0;
+        size_t horizonTriangles = 0;
+        size_t submittedTriangles = 0;
+        size_t facingAwayTriangles = 0;
+        size_t drawCalls = 0;
+        size_t loadedChunks = 0;
+        size_t generatedChunks = 0;
+        size_t discardedChunks = 0;
+        LatencyHistogram loadLatencies;   // fixed size, adding to it never allocates
+        size_t meshBytesInUse = 0;
+        size_t meshBytesReserved = 0;
+        float meshFragmentation = 0.0f;
+        size_t peakMeshBytes = 0;
+
+        // Largest resident set of the process so far
+        static size_t peakResidentBytes();
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// View frustum as six planes (ax + by + cz + d >= 0 is inside), extracted
+// straight from the view-projection matrix.
+class Frustum {
+    public:
+        Frustum() = default;
+        explicit Frustum(const glm::mat4& viewProjection);
+
+        void update(const glm::mat4& viewProjection);
+        bool intersectsBox(const glm::vec3& min, const glm::vec3& max) const;
+
+        glm::vec4 planes[6];
+};
+
+// Axis aligned boxes in structure-of-arrays layout so a whole frame's worth
+// of chunks can be tested in one tight, vectorizable loop.
+class BoxBatch {
+    public:
+        void clear();
+        void reserve(size_t count);
+        void add(const glm::vec3& min, const glm::vec3& max);
+        size_t size() const { return minX.size(); }
+
+        // visible[i] = 1 if box i is at least partly inside the frustum.
+        // Returns the number of visible boxes.
+        size_t cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+        std::vector<float> minX, minY, minZ;
+        std::vector<float> maxX, maxY, maxZ;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+
+// glad is generated for core 3.3 only. Newer entry points we can take
+// advantage of are looked up here at runtime, with a flag telling whether the
+// driver actually has them (Mesa llvmpipe does, macOS stops at 4.1).
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNGLMULTIDRAWARRAYSINDIRECTPROC)(GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+// Layout of one glMultiDrawElementsIndirect command
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Layout of one glMultiDrawArraysIndirect command
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+class GLExtensions {
+    public:
+        // Call once on the GL thread after gladLoadGLLoader
+        static void load(GLADloadproc loader);
+        static bool hasExtension(const std::string& name);
+
+        static int majorVersion;
+        static int minorVersion;
+
+        static bool bufferStorage;
+        static PFNGLBUFFERSTORAGEPROC glBufferStorage;
+
+        static bool multiDrawIndirect;
+        static PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
+        static PFNGLMULTIDRAWARRAYSINDIRECTPROC glMultiDrawArraysIndirect;
+
+    private:
+        static bool atLeast(int major, int minor);
+};
@@ -1,17 +1,37 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 #include <glad/glad.h>
+#ifdef __APPLE__
 #include <OpenGL/gl.h>
+#endif
 #include <GLFW/glfw3.h>
 #include <vector>
+#include <string>
 #include "Chunk.hpp"
 #include <utility>      // For std::pair
 #include <functional>   // For std::hash
+#include <shared_mutex>
 #include "ShaderLoader.hpp"
 #include "ThreadPool.hpp"
 #include "TexureManager.hpp"
+#include "ChunkMeshArena.hpp"
+#include "FaceArena.hpp"
+#include "MeshData.hpp"
+#include "CameraScript.hpp"
+#include "HeadlessContext.hpp"
+#include "RecyclingAllocator.hpp"
+#include "MPSCQueue.hpp"
+#include "Frustum.hpp"
+#include <unordered_map>
 class Chunk;
 
+// In chunks; the outer rings are drawn at lower detail (ChunkLod.hpp) and
+// only keep their downsampled cells, so voxel RAM mostly depends on the full
+// detail ring (--bench-lod); the horizon covers what lies beyond.
+#define DEFAULT_RENDER_DISTANCE 12
+// Scripted runs step the camera script this many frames per second
+#define SCRIPT_FPS 60
+
 
 struct pair_hash {
     template <class T1, class T2>
@@ -20,26 +40,72 @@ struct pair_hash {
     }
 };
 
+// Loaded chunks by chunk coordinates. Chunks stream in and out all the time,
+// so the map's nodes are recycled instead of allocated (main thread only)
+typedef std::unordered_map<std::pair<int, int>, Chunk*, pair_hash, std::equal_to<std::pair<int, int>>,
+                           RecyclingAllocator<std::pair<const std::pair<int, int>, Chunk*>>> ChunkMap;
+
 
 class Game {
 
 public:
-    Game(int width, int height);
+    Game(int width, int height, int renderDistance = DEFAULT_RENDER_DISTANCE, MeshFormat meshFormat = MeshFormat::Vertices);
     ~Game();
+    int renderDistance;
+    MeshFormat meshFormat;
     GLuint shaderProgram; 
     ShaderLoader* shaderLoader;
     TextureManager* textureManager;
     GLuint textureID;
+    GLuint atlasTextureID;  // block atlas, bound once per frame by the render queue
+    ChunkMeshArena meshArena;  // every chunk mesh lives here, GL thread only
+    FaceArena faceArena;       // or here, as face records, with MeshFormat::FaceRecords
     bool raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, Chunk& chunk, glm::ivec3& hitVoxel, float maxDistance);
     void drawRay(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float length);
 
     void Run();
-    std::unordered_map<std::pair<int, int>, Chunk*, pair_hash> loadedChunks;
+    // Call before Run. The camera flies the script at a fixed 1/60 s step
+    // instead of following input, and after frames Run prints the frame
+    // stats and returns
+    void playScript(const CameraScript& script, int frames);
+    // No window: renders offscreen at the window size (needs playScript)
+    void enableHeadless();
+    // Per frame limits on mesh uploads (UploadScheduler), 0 = no limit
+    void setUploadBudget(float millis, size_t bytes);
+    // Samples the camera while playing and writes it as a script on exit
+    void recordPath(const std::string& path);
+    // Worker pool telemetry (ThreadPool::Telemetry) as JSON
+    bool writePoolTelemetry(const std::string& path);
+    ChunkMap loadedChunks;
+    // Workers read loadedChunks (neighbor lookups) while the main thread inserts
+    // and unloads, so writers take this exclusively and worker lookups shared
+    std::shared_mutex loadedChunksMutex;
+    Chunk* findLoadedChunk(const std::pair<int, int>& chunkPos) {
+        std::shared_lock<std::shared_mutex> lock(loadedChunksMutex);
+        auto it = loadedChunks.find(chunkPos);
+        return it != loadedChunks.end() ? it->second : nullptr;
+    }
 
 
 private:
     int width, height;
     GLFWwindow* window;
+    bool headless = false;
+    int scriptFrames = 0;          // 0 = interactive
+    CameraScript cameraScript;
+    std::string recordingPath;
+    CameraScript recording;
+    HeadlessContext headlessContext;
+    // A chunk job's arguments wait in a slot so the task only captures this
+    // and the slot index, which std::function keeps inline without allocating
+    struct ChunkJob {
+        int x, z, lod;
+        bool remesh;
+        double requestedAt;
+    };
+    static constexpr uint32_t CHUNK_JOB_SLOTS = 4096;
+    std::vector<ChunkJob> chunkJobs;
+    MPSCQueue<uint32_t> freeChunkJobs;  // workers hand a slot back once they've copied it
     bool castRayForVoxel(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, glm::ivec3& hitVoxel, float maxDistance);
    
 
@@ -48,6 +114,16 @@ private:
     void Update(float deltaTime);
     void Render();
     void UpdateChunks();
+    // Fills in MemoryStats, every MEMORY_SAMPLE_FRAMES frames and before a report
+    void SampleMemory();
+    int framesSinceMemorySample = 0;
+    // Render's per frame chunk lists, sized for a full view in Init so a
+    // frame never grows them
+    BoxBatch chunkBounds;
+    std::vector<Chunk*> boundsChunks;
+    std::vector<uint8_t> chunkVisible;
+    std::vector<Chunk*> reachableChunks;
+    std::vector<std::pair<float, Chunk*>> visibleChunks;
     GLuint rayVAO, rayVBO;
 
 
@@ -0,0 +1,31 @@
+#pragma once
+#include <glad/glad.h>
+
+// GL context without a window, for benchmark runs on machines with no
+// display (CI, servers). It asks EGL for Mesa's surfaceless platform, which
+// works with llvmpipe on a box without a GPU or X server, and renders into
+// a framebuffer object of a fixed size instead of a window.
+//
+// Only built in where EGL is (HAVE_EGL, set by the Makefile on Linux);
+// elsewhere create() reports that and fails.
+class HeadlessContext {
+    public:
+        HeadlessContext();
+        ~HeadlessContext();
+
+        // Makes the context current and leaves the framebuffer bound
+        bool create(int width, int height);
+        void destroy();
+
+        // For gladLoadGLLoader and GLExtensions::load
+        static void* getProcAddress(const char* name);
+
+        GLuint framebuffer() const { return fbo; }
+
+    private:
+        void* display = nullptr;   // EGLDisplay
+        void* context = nullptr;   // EGLContext
+        GLuint fbo = 0, colorBuffer = 0, depthBuffer = 0;
+
+        bool createFramebuffer(int width, int height);
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Biome.hpp"
+#include "MPSCQueue.hpp"
+
+class ThreadPool;
+class Frustum;
+
+// Far terrain past the voxel chunks: a height field built only from the
+// generator's 2D surface noise (sampleSurface) and biome colours, no caves,
+// trees or voxels. The world is cut into square tiles that workers build as
+// they come into range; finished tiles go into fixed slots of one vertex
+// buffer and share one index buffer, so all of them are drawn with a single
+// glMultiDrawElementsBaseVertex.
+//
+// Tile x, z always lands in slot (x mod n, z mod n) of the n x n window
+// around the camera, and workers build into a few job slots whose buffers
+// are allocated once, so crossing tiles doesn't allocate.
+//
+// It is drawn before the chunks with its own, deeper projection and the
+// depth buffer is cleared afterwards, so it always sits behind the chunk
+// geometry. Fragments over the loaded voxel area are discarded.
+class HorizonRenderer {
+    public:
+        static const int TILE_BLOCKS = 256;                       // 16 chunks per side
+        static const int TILE_STEP = 8;                           // blocks between height samples
+        static const int TILE_GRID = TILE_BLOCKS / TILE_STEP + 1; // vertices per side, edges shared with the next tile
+
+        struct Vertex {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec3 color;
+        };
+
+        HorizonRenderer();
+        ~HorizonRenderer();
+
+        // GL thread. tileRadius tiles around the camera's are kept;
+        // maxSurfaceHeight is the one Chunk::initChunk uses.
+        void init(GLuint program, int tileRadius, int maxSurfaceHeight);
+        void shutdown();
+
+        // Main thread, once per frame: queues tiles that came into range on
+        // the pool, uploads finished ones and frees the ones left behind.
+        // voxelMin/voxelMax bound the loaded chunks on x and z in blocks;
+        // tiles entirely inside are not needed.
+        void update(const glm::vec3& cameraPos, const glm::vec2& voxelMin, const glm::vec2& voxelMax, ThreadPool& pool);
+        // Returns the number of tiles drawn
+        size_t draw(const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum, const glm::vec3& cameraPos,
+                    const glm::vec3& lightDir, const glm::vec3& lightColor, const glm::vec3& skyColor);
+
+        // Distance the tiles reach from the camera, in blocks
+        float reach() const { return static_cast<float>(tileRadius * TILE_BLOCKS); }
+        size_t residentTiles() const { return residentCount; }
+        size_t trianglesPerTile() const { return (TILE_GRID - 1) * (TILE_GRID - 1) * 2; }
+        size_t gpuBytes() const { return bufferBytes; }
+
+    private:
+        // Tiles queued on the pool at once, so chunk jobs queued later
+        // don't wait behind a whole ring of tiles
+        static const size_t MAX_TILES_IN_FLIGHT = 8;
+
+        // What a worker builds a tile in; the task only gets the job's index
+        struct TileJob {
+            int tileX, tileZ;
+            bool busy = false;
+            std::vector<float> heights;       // with a one sample border
+            std::vector<BiomeType> biomes;
+            std::vector<Vertex> vertices;
+        };
+        struct Slot {
+            int tileX, tileZ;
+            bool resident = false;
+        };
+        typedef std::pair<int, int> TileKey;
+
+        GLuint program = 0;
+        GLuint vao = 0, vbo = 0, ebo = 0;
+        GLint viewProjectionLocation = -1, cameraPosLocation = -1, voxelAreaLocation = -1;
+        GLint lightDirLocation = -1, lightColorLocation = -1, skyColorLocation = -1, fogRangeLocation = -1;
+        int tileRadius = 0;
+        int maxSurfaceHeight = 0;
+        GLsizei indexCount = 0;
+        size_t bufferBytes = 0;
+
+        int slotsPerSide = 0;
+        std::vector<Slot> slots;              // of the vertex buffer, see slotFor
+        size_t residentCount = 0;
+        TileJob jobs[MAX_TILES_IN_FLIGHT];
+        size_t jobsInFlight = 0;
+        MPSCQueue<uint32_t> finished;         // indices into jobs
+        std::vector<std::pair<int, TileKey>> missing;   // update's, reused
+        glm::vec2 voxelMin = glm::vec2(0.0f), voxelMax = glm::vec2(0.0f);
+
+        // Reused multi-draw argument arrays
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        std::vector<GLint> baseVertices;
+
+        bool wanted(const TileKey& tile, const TileKey& center) const;
+        size_t slotFor(const TileKey& tile) const;
+        bool inFlight(const TileKey& tile) const;
+        void buildTile(TileJob& job) const;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+// Generates and meshes sample chunks for every ring out to renderDistance
+// and reports triangles and mesh memory per ring, with and without level of
+// detail. No window or GL context needed. Run with:
+// ./main.exe --bench-lod [renderDistance]
+int runLodBenchmark(int renderDistance);
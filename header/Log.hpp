@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+// Leveled logging that stays off the hot path. LOG_INFO(a, b, ...) streams
+// its arguments straight into a slot of the calling thread's own ring, with
+// no lock and no flush; a background thread drains every ring a few times a
+// second and writes the lines out in time order. Warnings and errors go to
+// stderr, the rest to stdout. If a ring fills up, new lines are dropped and
+// counted rather than blocking the thread.
+//
+// Levels below LOG_LEVEL are compiled out entirely, arguments included, so
+// building with -DLOG_LEVEL=LOG_LEVEL_TRACE brings the per step raycast
+// output back.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+class Log {
+    public:
+        enum Level { Trace, Debug, Info, Warn, Error };
+
+        static const uint32_t LINES_PER_THREAD = 1024;   // power of two
+        static const uint32_t LINE_BYTES = 240;          // longer lines are cut
+
+        template <typename... Args>
+        static void write(Level level, const Args&... args) {
+            std::ostream& line = beginLine(level);
+            (line << ... << args);
+            endLine();
+        }
+
+        // Writes out everything logged so far, from any thread. Also runs at exit.
+        static void flush();
+
+    private:
+        struct ThreadRing;
+        struct Registry;
+        static Registry& registry();
+        static ThreadRing& threadRing();
+        // A stream over the next free slot, or one that ignores everything when the ring is full
+        static std::ostream& beginLine(Level level);
+        static void endLine();
+        static void writerLoop();
+};
+
+#if LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) Log::write(Log::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::write(Log::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log::write(Log::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log::write(Log::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log::write(Log::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
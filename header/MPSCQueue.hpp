@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free queue for many producers (the worker threads) and a
+// single consumer (the GL thread). Based on Dmitry Vyukov's bounded MPMC
+// queue: every cell carries a sequence number telling producers and the
+// consumer whose turn it is, so neither side ever takes a lock.
+template <typename T>
+class MPSCQueue {
+    public:
+        // capacity is rounded up to a power of two
+        explicit MPSCQueue(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            mask = size - 1;
+            cells = std::vector<Cell>(size);
+            for (size_t i = 0; i < size; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MPSCQueue(const MPSCQueue&) = delete;
+        MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+        // Any thread. Returns false if the queue is full.
+        bool tryPush(const T& value) {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = value;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Any thread, yields until there is room
+        void push(const T& value) {
+            while (!tryPush(value)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Consumer thread only
+        bool tryPop(T& value) {
+            Cell& cell = cells[dequeuePos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePos + 1) < 0) {
+                return false;
+            }
+            value = cell.value;
+            cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+            dequeuePos++;
+            return true;
+        }
+
+        size_t capacity() const { return mask + 1; }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence{0};
+            T value{};
+        };
+
+        std::vector<Cell> cells;
+        size_t mask = 0;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) size_t dequeuePos = 0;
+};
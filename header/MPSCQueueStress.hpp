@@ -0,0 +1,8 @@
+#pragma once
+
+// Hammers MPSCQueue with several producer threads and one consumer, and
+// checks that every item arrives exactly once and in order per producer.
+// Meant for a ThreadSanitizer build (make stress-mpsc), but the checks hold
+// in any build. No window or GL context needed. Run with:
+// ./main.exe --stress-mpsc [producers]
+int runMPSCQueueStress(int producers);
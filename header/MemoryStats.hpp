@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+
+// Where the memory goes, per subsystem. The main thread walks what it owns
+// (loaded chunks, queues, GL buffers) every few frames and sets each category's
+// size; memory that the workers grow on their own, like the mesher scratch,
+// is counted as it changes with track(). Every category keeps its high-water
+// mark, and the RAM and VRAM totals can be checked against a budget.
+enum class MemoryCategory {
+    Voxels,          // voxel arrays of the loaded chunks
+    ChunkMeshes,     // CPU mesh copies the loaded chunks hold on to (staging ring was full)
+    ChunkOther,      // the Chunk objects, colours, tints, occluder boxes
+    MesherScratch,   // every thread's MeshData::threadScratch
+    PendingChunks,   // meshed chunks waiting for upload, and retired ones waiting to be reclaimed
+    PooledChunks,    // chunks kept by ChunkPool for reuse
+    GpuMeshes,       // mesh or face arena buffers, as reserved
+    GpuStaging,      // the staging ring
+    GpuHorizon,      // horizon vertex and index buffers
+    Count
+};
+
+// One chunk's share, see Chunk::memoryUsage
+struct ChunkMemory {
+    size_t voxels = 0;
+    size_t cpuMesh = 0;   // capacity of the mesh copy it owns
+    size_t other = 0;
+    size_t gpuMesh = 0;   // what its uploaded mesh takes in the arena
+
+    size_t ram() const { return voxels + cpuMesh + other; }
+    void add(const ChunkMemory& chunk) {
+        voxels += chunk.voxels;
+        cpuMesh += chunk.cpuMesh;
+        other += chunk.other;
+        gpuMesh += chunk.gpuMesh;
+    }
+};
+
+class MemoryStats {
+    public:
+        static const int CATEGORIES = static_cast<int>(MemoryCategory::Count);
+
+        struct Snapshot {
+            size_t current[CATEGORIES];
+            size_t peak[CATEGORIES];
+            size_t ramBytes, vramBytes;
+            size_t peakRamBytes, peakVramBytes;
+            size_t chunks;             // loaded chunks in the last sample
+            ChunkMemory chunkTotal;    // summed over them
+            ChunkMemory largestChunk;  // by RAM
+        };
+
+        static const char* name(MemoryCategory category);
+        static bool isGpu(MemoryCategory category);
+
+        // Main thread: replaces the category's size for this sample
+        static void set(MemoryCategory category, size_t bytes);
+        // Any thread: for memory nobody can walk, counted as it grows or shrinks
+        static void track(MemoryCategory category, long long deltaBytes);
+        // Main thread: per chunk breakdown of the loaded chunks
+        static void setChunks(size_t chunks, const ChunkMemory& total, const ChunkMemory& largest);
+        // Main thread, after a sample's set calls: updates the peaks and checks the budget
+        static void endSample();
+
+        static Snapshot snapshot();
+
+        // In bytes, 0 = none. Going over is logged the first time and then
+        // remembered until exit.
+        static void setBudget(size_t ramBytes, size_t vramBytes);
+        static bool budgetExceeded();
+
+        // Table of current and peak bytes per category to stdout
+        static void print();
+};
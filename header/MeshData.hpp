@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// How chunk meshes are stored on the GPU, chosen once at startup
+enum class MeshFormat {
+    Vertices,      // 4 vertices (position, texture coordinates) per face in ChunkMeshArena, drawn with its shared quad indices
+    FaceRecords,   // one FaceRecord per face in FaceArena, expanded into a quad by VertShaderFaces
+};
+
+// One face for the vertex pulling path, 8 bytes instead of 80. The box is
+// in blocks relative to the chunk, so chunks can't be bigger than 16.
+struct FaceRecord {
+    uint32_t box;      // low corner x, y, z and size - 1 on x, y, z, 4 bits each, then the Face in bits 24..26
+    uint32_t sprite;   // atlas tile x | y << 4
+};
+
+// CPU side of a chunk mesh. The mesher always writes into the calling
+// thread's scratch instance, which keeps its capacity between chunks, so a
+// warmed up worker meshes without touching the heap.
+//
+// The mesher emits all faces of one direction before the next, in Face
+// order, so each direction is one contiguous range of quads that the
+// renderer can skip as a whole when it faces away from the camera.
+struct MeshData {
+    std::vector<float> vertices;
+    std::vector<float> texCoordsArray;
+    std::vector<FaceRecord> faceRecords;
+    uint32_t directionQuads[6] = {};   // quads per Face, in Face order
+
+    void clear() {
+        vertices.clear();
+        texCoordsArray.clear();
+        faceRecords.clear();
+        std::fill(std::begin(directionQuads), std::end(directionQuads), 0u);
+    }
+
+    // Copies without giving up our own capacity
+    void assign(const MeshData& other) {
+        vertices.assign(other.vertices.begin(), other.vertices.end());
+        texCoordsArray.assign(other.texCoordsArray.begin(), other.texCoordsArray.end());
+        faceRecords.assign(other.faceRecords.begin(), other.faceRecords.end());
+        std::copy(std::begin(other.directionQuads), std::end(other.directionQuads), directionQuads);
+    }
+
+    size_t byteSize() const {
+        return vertices.size() * sizeof(float) + texCoordsArray.size() * sizeof(float) + faceRecords.size() * sizeof(FaceRecord);
+    }
+
+    // What the vectors hold on to, used or not
+    size_t capacityBytes() const {
+        return vertices.capacity() * sizeof(float) + texCoordsArray.capacity() * sizeof(float) + faceRecords.capacity() * sizeof(FaceRecord);
+    }
+
+    // Room for this many quads in the format's own arrays
+    void reserveQuads(size_t quads, MeshFormat format) {
+        if (format == MeshFormat::FaceRecords) {
+            faceRecords.reserve(quads);
+        } else {
+            vertices.reserve(quads * 12);
+            texCoordsArray.reserve(quads * 8);
+        }
+    }
+
+    size_t triangleCount() const {
+        return vertices.size() / 12 * 2 + faceRecords.size() * 2;   // 4 vertices of 3 floats per quad
+    }
+
+    static MeshData& threadScratch();
+    // Reports how much this thread's scratch grew since the last call to MemoryStats
+    static void trackScratchGrowth();
+};
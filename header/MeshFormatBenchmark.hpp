@@ -0,0 +1,6 @@
+#pragma once
+
+// Meshes the same sample chunks as vertices and as face records and prints
+// mesh bytes (what gets uploaded) and meshing throughput for both. No window
+// or GL context needed. Run with: ./main.exe --bench-mesh-format
+int runMeshFormatBenchmark();
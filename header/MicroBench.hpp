@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Small header-only microbenchmark harness. Each benchmark body is timed in
+// batches sized to take about SAMPLE_MILLIS; the median batch is the result,
+// so one descheduled batch doesn't move it. Results go to stdout as a table
+// and to a JSON file that compare() can diff against a later run.
+namespace microbench {
+
+    // Keeps the compiler from dropping a computation whose result is unused
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct Result {
+        std::string name;
+        double nsPerOp;      // median over the samples
+        double minNsPerOp;
+        double maxNsPerOp;
+        uint64_t opsPerSample;
+    };
+
+    class Runner {
+        public:
+            static constexpr double SAMPLE_MILLIS = 20.0;
+            static const int SAMPLES = 15;
+
+            // body() does opsPerCall operations
+            template <typename Body>
+            void run(const std::string& name, Body&& body, uint64_t opsPerCall = 1) {
+                // Grow the batch until it takes a measurable amount of time, then scale it to SAMPLE_MILLIS
+                uint64_t calls = 1;
+                double millis = timeCalls(body, calls);
+                while (millis < SAMPLE_MILLIS / 10.0 && calls < (1ull << 40)) {
+                    calls *= 10;
+                    millis = timeCalls(body, calls);
+                }
+                calls = std::max<uint64_t>(1, static_cast<uint64_t>(calls * SAMPLE_MILLIS / std::max(millis, 1e-6)));
+
+                std::vector<double> samples;
+                for (int i = 0; i < SAMPLES; i++) {
+                    samples.push_back(timeCalls(body, calls) * 1e6 / (calls * opsPerCall));
+                }
+                std::sort(samples.begin(), samples.end());
+                Result result = {name, samples[samples.size() / 2], samples.front(), samples.back(), calls * opsPerCall};
+                printf("%-36s %12.2f ns/op  (min %.2f, max %.2f, %llu ops/sample)\n", name.c_str(), result.nsPerOp,
+                       result.minNsPerOp, result.maxNsPerOp, static_cast<unsigned long long>(result.opsPerSample));
+                fflush(stdout);
+                results.push_back(result);
+            }
+
+            const std::vector<Result>& all() const { return results; }
+
+            bool writeJson(const std::string& path) const {
+                std::ofstream out(path);
+                if (!out) {
+                    return false;
+                }
+                out << "{\n  \"benchmarks\": [\n";
+                for (size_t i = 0; i < results.size(); i++) {
+                    const Result& result = results[i];
+                    out << "    {\"name\": \"" << result.name << "\", \"ns_per_op\": " << result.nsPerOp
+                        << ", \"min_ns_per_op\": " << result.minNsPerOp << ", \"max_ns_per_op\": " << result.maxNsPerOp
+                        << ", \"ops_per_sample\": " << result.opsPerSample << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+                }
+                out << "  ]\n}\n";
+                return static_cast<bool>(out);
+            }
+
+        private:
+            std::vector<Result> results;
+
+            template <typename Body>
+            static double timeCalls(Body& body, uint64_t calls) {
+                auto start = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < calls; i++) {
+                    body();
+                }
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+    };
+
+    // Reads back the name and ns_per_op of every benchmark writeJson wrote
+    inline bool readJson(const std::string& path, std::vector<Result>& results) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        std::string json = text.str();
+        const std::string NAME = "\"name\": \"", NS = "\"ns_per_op\": ";
+        for (size_t at = json.find(NAME); at != std::string::npos; at = json.find(NAME, at)) {
+            at += NAME.size();
+            size_t nameEnd = json.find('"', at);
+            size_t nsAt = json.find(NS, nameEnd);
+            if (nameEnd == std::string::npos || nsAt == std::string::npos) {
+                return false;
+            }
+            Result result = {json.substr(at, nameEnd - at), std::strtod(json.c_str() + nsAt + NS.size(), nullptr), 0.0, 0.0, 0};
+            results.push_back(result);
+            at = nsAt;
+        }
+        return true;
+    }
+
+    // Prints every benchmark in both runs; returns how many got slower by more than thresholdPercent
+    inline int compare(const std::vector<Result>& baseline, const std::vector<Result>& current, double thresholdPercent) {
+        int regressions = 0;
+        printf("%-36s %12s %12s %9s\n", "benchmark", "base ns/op", "new ns/op", "change");
+        for (const Result& now : current) {
+            auto before = std::find_if(baseline.begin(), baseline.end(), [&](const Result& r) { return r.name == now.name; });
+            if (before == baseline.end()) {
+                printf("%-36s %12s %12.2f %9s\n", now.name.c_str(), "-", now.nsPerOp, "new");
+                continue;
+            }
+            double change = (now.nsPerOp / before->nsPerOp - 1.0) * 100.0;
+            bool regressed = change > thresholdPercent;
+            regressions += regressed ? 1 : 0;
+            printf("%-36s %12.2f %12.2f %+8.1f%%%s\n", now.name.c_str(), before->nsPerOp, now.nsPerOp, change,
+                   regressed ? "  REGRESSION" : (change < -thresholdPercent ? "  faster" : ""));
+        }
+        return regressions;
+    }
+}
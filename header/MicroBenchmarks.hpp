@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+// Times engine hot paths one call at a time: terrain generation, meshing,
+// voxel lookups, raycasts, noise, texture lookup, thread pool round
+// trips and the MPSC queue. No window or GL context needed. Run with:
+//   ./main.exe --bench-micro [results.json]
+//   ./main.exe --bench-compare baseline.json results.json [threshold %]
+// The compare exits non-zero when something got slower than the threshold.
+int runMicroBenchmarks(const std::string& jsonPath);
+int compareMicroBenchmarks(const std::string& baselinePath, const std::string& currentPath, double thresholdPercent);
@@ -0,0 +1,5 @@
+#pragma once
+
+// Synthetic scenes for timing the software occlusion culler without a
+// window or GL context. Run with: ./main.exe --bench-occlusion
+int runOcclusionBenchmark();
@@ -0,0 +1,68 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ThreadPool.hpp"
+
+// Software occlusion culling on the CPU, no GPU readback needed.
+//
+// Each frame the nearest chunks' solid boxes (see Chunk::occluderBoxes) are
+// rasterized into a small depth buffer, split in horizontal bands across a
+// few threads, 4 pixels at a time with SSE/NEON. A min-depth pyramid is
+// built on top, and chunk bounds are tested against the coarsest level that
+// covers them in a few texels.
+//
+// Depth is stored as 1/w (bigger is nearer), which interpolates linearly
+// in screen space. Occluders are clipped at the near plane and occludees
+// touching it are always visible, so the culler only ever errs on the side
+// of drawing.
+class OcclusionCuller {
+    public:
+        static constexpr int WIDTH = 256;
+        static constexpr int HEIGHT = 128;
+
+        OcclusionCuller(size_t threads = 4);
+        ~OcclusionCuller();
+
+        // Call in this order every frame
+        void beginFrame(const glm::mat4& viewProjection);
+        void addOccluder(const glm::vec3& min, const glm::vec3& max);
+        void rasterize();
+        // True if the box may be visible
+        bool testBox(const glm::vec3& min, const glm::vec3& max) const;
+
+        size_t occluderCount() const { return boxes.size() / 2; }
+        size_t triangleCount() const { return triangles.size(); }
+        size_t threadCount() const { return bands; }
+        // Nearest occluder depth (1/w) at pixel x, y; 0 where nothing was drawn
+        float depthAt(int x, int y) const { return levels[0][y * WIDTH + x]; }
+
+    private:
+        struct Triangle {
+            float x[3], y[3], invW[3];   // pixel coordinates
+            int minX, maxX, minY, maxY;
+        };
+
+        glm::mat4 viewProjection;
+        std::vector<glm::vec3> boxes;          // min, max pairs
+        std::vector<Triangle> triangles;
+        // levels[0] is the full buffer, every next level the min of 2x2
+        std::vector<std::vector<float>> levels;
+        std::vector<int> levelWidth, levelHeight;
+
+        size_t bands;
+        std::unique_ptr<ThreadPool> pool;      // bands - 1 helpers, the caller takes a band too
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        size_t bandsDone = 0;
+
+        void setupTriangles();
+        void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+        void addClippedTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+        void rasterizeBand(int rowBegin, int rowEnd);
+        void buildPyramid();
+};
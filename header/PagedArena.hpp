@@ -0,0 +1,95 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BufferSubAllocator.hpp"
+
+// What ChunkMeshArena and FaceArena have in common: meshes are handed out in
+// whole pages of pageItems items (vertices, face records) through a
+// BufferSubAllocator, behind small integer handles, and the buffers grow by
+// doubling and are compacted a few allocations per frame.
+//
+// The arena supplies the buffers: it copies pages when an allocation moves,
+// reallocates its buffers when they grow, and writes an allocation's pages
+// into its page table whenever they or its offset change.
+class PagedArena {
+    public:
+        typedef uint32_t Handle;   // 0 = no allocation
+
+        struct Stats {
+            size_t bytesInUse;        // pages handed out
+            size_t bytesReserved;     // size of the arena buffers
+            float vertexFragmentation;
+            size_t inPlaceUpdates;    // remeshes that kept their allocation
+            size_t relocations;       // remeshes that had to move
+            size_t compactions;
+        };
+
+        PagedArena(const char* name, uint32_t pageItems);
+        virtual ~PagedArena();
+
+        // GL thread only from here on
+        // Grows or compacts the buffers if needed, returns 0 if it still can't fit
+        Handle allocate(uint32_t itemCount, const glm::vec3& offset);
+        void free(Handle handle);
+        // For remeshing: keeps the allocation where it is when the new mesh
+        // fits (shrinking or growing into free space behind it), moves it
+        // otherwise. May return a different handle.
+        Handle reallocate(Handle handle, uint32_t itemCount, const glm::vec3& offset);
+
+        // Compacts a few allocations at a time once free space has become too
+        // scattered; call once a frame
+        void maintain();
+
+        uint32_t liveAllocations() const { return liveCount; }
+        float fragmentation() const { return pages.fragmentation(); }
+
+    protected:
+        struct Allocation {
+            uint32_t firstPage;
+            uint32_t pageCount;
+            uint32_t itemCount;
+            glm::vec3 offset;
+            bool live;
+        };
+
+        const uint32_t pageItems;
+        BufferSubAllocator pages;
+
+        // For init and shutdown, once the buffers are made or gone
+        void resetPages(uint32_t pageCount);
+        void clearAllocations();
+        const Allocation& allocationFor(Handle handle) const { return allocations[handle - 1]; }
+        // pageBytes is what a page costs in every buffer, page table included
+        Stats pageStats(size_t pageBytes) const;
+
+        // Copy pageCount pages from fromPage to toPage inside the buffers; the
+        // ranges never overlap
+        virtual void movePages(uint32_t fromPage, uint32_t toPage, uint32_t pageCount) = 0;
+        // Replace the buffers with ones of pageCount pages, keeping the
+        // current pages.capacity() pages
+        virtual void growBuffers(uint32_t pageCount) = 0;
+        virtual void writePageTable(const Allocation& allocation) = 0;
+
+    private:
+        const char* name;
+        std::vector<Allocation> allocations;   // index = handle - 1
+        std::vector<Handle> freeHandles;
+        uint32_t liveCount = 0;
+        size_t inPlaceUpdates = 0;
+        size_t relocations = 0;
+        size_t compactions = 0;
+        bool compacting = false;
+        size_t compactCursor = 0;      // next handle - 1 the running pass looks at
+        bool compactMoved = false;     // the running pass moved something
+        bool compactStuck = false;     // the last pass moved nothing, wait for a free
+
+        uint32_t pagesFor(uint32_t itemCount) const { return (itemCount + pageItems - 1) / pageItems; }
+        // Doubles the buffers until at most 3/4 full with pageCount more pages
+        void grow(uint32_t pageCount);
+        // Moves up to COMPACT_ALLOCATIONS_PER_FRAME allocations into free space
+        // before them; a pass walks every handle once
+        void compactStep();
+        void move(Allocation& allocation, uint32_t firstPage);
+};
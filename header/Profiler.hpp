@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Scoped timing zones for finding where frame time goes. A zone is one
+// PROFILE_ZONE("name") line at the top of a scope; nested zones on the same
+// thread show up nested in the trace. Every thread writes into its own
+// ring of the last EVENTS_PER_THREAD zones, so recording takes no lock, and
+// writeChromeTrace turns the rings into a file for chrome://tracing or
+// Perfetto.
+//
+// Zones are timed with the CPU's cycle counter where there is one (a
+// steady_clock read costs about twice as much) and converted to time when
+// exported. Build with -DPROFILER_ENABLED=0 to compile every zone out.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+class Profiler {
+    public:
+        static const uint32_t EVENTS_PER_THREAD = 1 << 15;   // power of two
+
+        struct Event {
+            const char* name;   // string literal, never copied
+            int64_t start;      // ticks()
+            int64_t end;
+        };
+
+        static int64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+            return static_cast<int64_t>(__rdtsc());
+#elif defined(__aarch64__)
+            int64_t value;
+            asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+            return value;
+#else
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+        }
+
+        static void record(const char* name, int64_t start, int64_t end);
+        // Shows up as the thread's name in the trace, call from the thread itself
+        static void setThreadName(const std::string& name);
+
+        // Zones that ended within the last seconds (0 = everything still in the rings)
+        static bool writeChromeTrace(const std::string& path, double lastSeconds = 0.0);
+
+    private:
+        struct ThreadBuffer;
+        struct Registry;
+        static ThreadBuffer& threadBuffer();
+        static Registry& registry();
+        // ticks() and steady_clock read together when the first thread registered,
+        // the tick rate is measured against it on export
+        static void clockStart(int64_t& startTicks, std::chrono::steady_clock::time_point& startTime);
+};
+
+class ProfileZone {
+    public:
+        explicit ProfileZone(const char* name) : name(name), start(Profiler::ticks()) {}
+        ~ProfileZone() { Profiler::record(name, start, Profiler::ticks()); }
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name;
+        int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
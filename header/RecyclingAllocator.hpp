@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+// Allocator for node based containers (std::unordered_map, std::map,
+// std::set) that puts freed nodes on a free list and hands them out again
+// instead of going back to the heap, so once a container has been as big as
+// it gets, inserting and erasing stops allocating. Anything but a single
+// object (an unordered container's bucket array) goes to operator new.
+//
+// The free lists are per node type and thread_local, and never handed back:
+// nodes must be allocated and freed on the same thread, which for the chunk
+// maps and the arenas' free block maps is the main thread.
+template <typename T>
+class RecyclingAllocator {
+    public:
+        typedef T value_type;
+
+        RecyclingAllocator() noexcept {}
+        template <typename U>
+        RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count) {
+            if (count != 1) {
+                return static_cast<T*>(::operator new(count * sizeof(T)));
+            }
+            FreeNode*& head = freeList();
+            if (head != nullptr) {
+                FreeNode* node = head;
+                head = node->next;
+                return reinterpret_cast<T*>(node);
+            }
+            return static_cast<T*>(::operator new(sizeof(T) < sizeof(FreeNode) ? sizeof(FreeNode) : sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+            if (count != 1) {
+                ::operator delete(pointer);
+                return;
+            }
+            FreeNode* node = reinterpret_cast<FreeNode*>(pointer);
+            node->next = freeList();
+            freeList() = node;
+        }
+
+        template <typename U>
+        bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const RecyclingAllocator<U>&) const noexcept { return false; }
+
+    private:
+        struct FreeNode {
+            FreeNode* next;
+        };
+
+        static FreeNode*& freeList() {
+            static thread_local FreeNode* head = nullptr;
+            return head;
+        }
+};
+
+// Leaves count nodes of Container's node type on this thread's free list, by
+// filling a throwaway container with makeValue(0 .. count-1), so the first
+// count inserts into real containers of that type don't allocate either
+template <typename Container, typename MakeValue>
+void warmRecycledNodes(size_t count, MakeValue makeValue) {
+    Container warm;
+    for (size_t i = 0; i < count; i++) {
+        warm.insert(makeValue(i));
+    }
+}
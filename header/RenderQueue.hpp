@@ -0,0 +1,81 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "GLExtensions.hpp"
+
+class ChunkMeshArena;
+class FaceArena;
+
+// Chunks submit draw items here instead of drawing themselves. The queue
+// sorts them by program and texture, uploads the per-frame uniforms once
+// through a uniform buffer, and draws each run of items that share state
+// with one multi-draw out of the chunk mesh arena:
+// glMultiDrawElementsIndirect when the driver has it, otherwise
+// glMultiDrawElementsBaseVertex (GL 3.3).
+//
+// With the vertex pulling path the items come out of the FaceArena instead
+// and are drawn with glMultiDrawArraysIndirect / glMultiDrawArrays.
+class RenderQueue {
+    public:
+        struct DrawItem {
+            GLuint program;
+            GLuint texture;
+            GLsizei indexCount;  // vertex count for FaceArena draws
+            GLuint firstIndex;   // in the arena's quad index buffer, first vertex for FaceArena draws
+            GLint baseVertex;    // in the arena vertex buffers
+        };
+
+        // Matches the std140 PerFrame block in the chunk shaders
+        struct PerFrame {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec4 lightDir;
+            glm::vec4 lightColor;
+            glm::vec4 ambientColor;
+        };
+
+        RenderQueue();
+        ~RenderQueue();
+
+        // GL thread, once the program, atlas and arena exist
+        void init(GLuint program, GLuint atlasTexture, ChunkMeshArena& arena);
+        void init(GLuint program, GLuint atlasTexture, FaceArena& faces);
+        void shutdown();
+
+        // Room for this many items a frame without growing anything
+        void reserve(size_t count);
+        void submit(const DrawItem& item);
+        // Issues every submitted draw and empties the queue. Returns the
+        // number of GL draw calls made.
+        size_t flush(const PerFrame& perFrame);
+
+        size_t size() const { return items.size(); }
+        bool usesIndirect() const { return GLExtensions::multiDrawIndirect; }
+
+    private:
+        static const GLuint PER_FRAME_BINDING = 0;
+        static const GLint PAGE_TABLE_UNIT = 1;
+        static const GLint FACE_RECORD_UNIT = 2;
+
+        std::vector<DrawItem> items;
+        ChunkMeshArena* arena = nullptr;
+        FaceArena* faces = nullptr;
+        GLuint perFrameUBO = 0;
+        GLuint indirectBuffer = 0;
+        size_t indirectCapacity = 0;
+
+        // Reused multi-draw argument arrays
+        std::vector<DrawElementsIndirectCommand> commands;
+        std::vector<DrawArraysIndirectCommand> arrayCommands;
+        std::vector<GLsizei> counts;
+        std::vector<GLint> firsts;
+        std::vector<const void*> offsets;
+        std::vector<GLint> baseVertices;
+
+        void initShared(GLuint program, GLuint atlasTexture);
+        void drawRun(size_t begin, size_t end);
+        void drawFaceRun(size_t begin, size_t end);
+        void reserveIndirect(size_t bytes);
+};
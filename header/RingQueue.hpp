@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// First in, first out over a vector that only grows, for queues with a
+// steady flow through them: a std::deque news a block every few pushes,
+// this stops allocating once it has been as long as it gets. Popped slots
+// keep their contents, and whatever capacity those own, until push() hands
+// them out again. Not thread safe.
+template <typename T>
+class RingQueue {
+    public:
+        explicit RingQueue(size_t capacity = 16) : slots(capacity > 0 ? capacity : 1) {}
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+
+        // i = 0 is the front
+        T& operator[](size_t i) { return slots[(first + i) % slots.size()]; }
+        const T& operator[](size_t i) const { return slots[(first + i) % slots.size()]; }
+        T& front() { return slots[first]; }
+
+        // The new slot at the back, to be filled in by the caller
+        T& push() {
+            if (count == slots.size()) {
+                std::vector<T> grown(slots.size() * 2);
+                for (size_t i = 0; i < slots.size(); i++) {
+                    grown[i] = std::move((*this)[i]);
+                }
+                slots.swap(grown);
+                first = 0;
+            }
+            count++;
+            return (*this)[count - 1];
+        }
+        void push(const T& value) { push() = value; }
+        void pop() {
+            first = (first + 1) % slots.size();
+            count--;
+        }
+        void clear() {
+            first = 0;
+            count = 0;
+        }
+
+    private:
+        std::vector<T> slots;
+        size_t first = 0, count = 0;
+};
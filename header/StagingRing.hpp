@@ -0,0 +1,76 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "RingQueue.hpp"
+
+// Ring buffer that worker threads write finished meshes into, so the GL
+// thread only has to issue buffer-to-buffer copies.
+//
+// With GL_ARB_buffer_storage the ring is a persistently mapped, coherent GL
+// buffer and uploads are glCopyBufferSubData calls. On plain GL 3.3 the ring
+// lives in client memory and the GL thread copies it into a glMapBufferRange
+// mapping of the destination instead. Either way a region is only reused
+// once the GL commands reading it have completed (tracked with fences).
+class StagingRing {
+    public:
+        struct Region {
+            size_t offset = 0;
+            size_t size = 0;
+            uint64_t id = 0;
+            bool valid() const { return size > 0; }
+        };
+
+        StagingRing();
+        ~StagingRing();
+
+        // GL thread
+        bool init(size_t capacityBytes);
+        void shutdown();
+        void copyTo(const Region& region, size_t srcOffset, GLenum target, GLintptr dstOffset, size_t size);
+        void retire(const Region& region);   // all copies out of region have been issued
+        void fenceFrame();                   // call after the frame's copies
+        void collect();                      // frees regions whose fence has signaled
+
+        // Any thread
+        bool reserve(size_t bytes, Region& region);
+        void* data(const Region& region) { return base + region.offset; }
+        void release(const Region& region);  // region that was never copied
+        bool isInitialized() const { return base != nullptr; }
+        bool isPersistent() const { return persistent; }
+        size_t bytesInUse() const;
+        size_t capacityBytes() const { return capacity; }
+
+    private:
+        enum class State { Reserved, Retired, Fenced, Free };
+        struct Entry {
+            size_t offset;
+            size_t size;
+            uint64_t id;
+            State state;
+            uint64_t fence;     // serial of the fence covering it, once Fenced
+        };
+        struct PendingFence {
+            GLsync fence;
+            uint64_t serial;
+        };
+
+        GLuint buffer = 0;
+        char* base = nullptr;
+        std::vector<char> clientMemory;     // GL 3.3 fallback storage
+        size_t capacity = 0;
+        bool persistent = false;
+
+        mutable std::mutex mutex;
+        RingQueue<Entry> entries;           // allocation order
+        size_t head = 0;
+        uint64_t nextId = 1;
+        bool retiredThisFrame = false;
+        uint64_t nextFence = 1;
+        RingQueue<PendingFence> fences;     // GL thread only
+
+        void setState(uint64_t id, State state);
+        void popFreeEntries();
+};
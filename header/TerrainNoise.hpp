@@ -0,0 +1,28 @@
+#pragma once
+#include "PerlinNoise.hpp"
+#include "Biome.hpp"
+#include <cstdint>
+
+// Default world seed, --seed or a replayed camera path can pick another
+#define TERRAIN_SEED 1234
+
+// Surface of one world column, from the 2D noise only (no caves, no trees).
+// Chunk::initChunk fills voxels from this and the horizon tiles are built
+// from it, so both line up.
+struct SurfaceSample {
+    BiomeType biome;
+    int height;       // y of the surface block, 0 .. maxHeight - 1
+};
+
+// Call before the first chunk or horizon tile is built, the noise is made once
+void setTerrainSeed(uint32_t seed);
+uint32_t terrainSeed();
+
+// Shared by every thread, the noise is read only once built
+const siv::PerlinNoise& terrainNoise();
+
+// Random looking but fixed per column and seed, on any thread in any order
+// (tree placement), so the same seed always grows the same world
+uint32_t columnHash(int worldX, int worldZ);
+
+SurfaceSample sampleSurface(const siv::PerlinNoise& noise, int worldX, int worldZ, int maxHeight);
@@ -1,24 +1,97 @@
 #pragma once
 #include <thread>
-#include <queue>
 #include <functional>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "LatencyHistogram.hpp"
 
+// Telemetry is always on: a task costs three clock reads and a few relaxed
+// atomics on the worker's own counters, next to chunk jobs of milliseconds.
 class ThreadPool {
     public:
+        struct WorkerTelemetry {
+            uint64_t tasks;
+            double busySeconds;   // running tasks
+            double idleSeconds;   // waiting for one
+        };
+        struct DepthSample {
+            double seconds;       // since the pool started
+            size_t depth;         // tasks waiting
+            uint64_t completed;   // tasks finished so far
+        };
+        struct Telemetry {
+            double uptimeSeconds;
+            uint64_t enqueued, completed;
+            uint64_t dropped;             // queued tasks thrown away by drain
+            size_t queueDepth, peakQueueDepth;
+            double tasksPerSecond;        // over the last second of depthHistory
+            double utilization;           // busy / (busy + idle) over all workers
+            LatencyHistogram waitNanos;   // enqueue to start
+            LatencyHistogram runNanos;
+            std::vector<WorkerTelemetry> workers;
+            std::vector<DepthSample> depthHistory;   // oldest first
+        };
+
+        // Queue depth is sampled at most this often, HISTORY_SAMPLES are kept
+        static constexpr double DEPTH_SAMPLE_SECONDS = 0.01;
+        static const size_t HISTORY_SAMPLES = 1000;
+        static const size_t INITIAL_QUEUE_CAPACITY = 256;
+
         ThreadPool(size_t numThreads);
         ~ThreadPool();
         void enqueueTask(std::function<void()> task);
+        // Drops the queued tasks and waits for the running ones, for owners
+        // of the state the tasks capture to call before tearing it down
+        void drain();
+
+        // Any thread
+        Telemetry telemetry();
+        bool writeTelemetryJson(const std::string& path);
+
     private:
+        struct Task {
+            std::function<void()> function;
+            uint64_t enqueuedAt;   // nowNanos()
+        };
+        struct alignas(64) WorkerStats {
+            LatencyHistogram waitNanos;
+            LatencyHistogram runNanos;
+            std::atomic<uint64_t> tasks{0};
+            std::atomic<uint64_t> busyNanos{0};
+            std::atomic<uint64_t> idleNanos{0};
+        };
+
         std::vector<std::thread> workers;
-        std::queue<std::function<void()>> tasks;
+        // Ring of queued tasks that only grows, so a steady flow of tasks
+        // doesn't allocate (a std::deque news a block every few pushes)
+        std::vector<Task> tasks;
+        size_t taskHead = 0, taskCount = 0;
+        std::vector<std::unique_ptr<WorkerStats>> workerStats;
 
         std::mutex queueMutex;
         std::condition_variable condition;
         bool stop;
 
-        void workerThread();
-};
+        // Under queueMutex
+        uint64_t startNanos;
+        uint64_t enqueued = 0;
+        uint64_t dropped = 0;
+        size_t peakDepth = 0;
+        uint64_t lastDepthSample = 0;
+        std::vector<DepthSample> depthHistory;   // ring of HISTORY_SAMPLES
+        size_t nextDepthSample = 0;
 
+        std::atomic<uint64_t> completed{0};
+        std::atomic<size_t> running{0};   // raised under queueMutex
+
+        void pushTask(Task&& task);
+        Task popTask();
+        void workerThread(size_t index);
+        void sampleDepth(uint64_t now);
+        static uint64_t nowNanos();
+};
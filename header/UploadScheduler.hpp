@@ -0,0 +1,50 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+class Chunk;
+
+// Default per frame budget, --upload-budget-ms / --upload-budget-mb. On the
+// headless flight it had the lowest p99 of the budgets tried (0.25 to 4 MB);
+// a smaller byte budget mostly cuts the worst frame instead.
+#define UPLOAD_BUDGET_MS 2.0f
+#define UPLOAD_BUDGET_BYTES (4 * 1024 * 1024)
+
+// Spreads GPU mesh uploads over several frames.
+// Chunks finished by the workers wait here; every frame the nearest ones are
+// uploaded until either the time or the byte budget runs out. At least one
+// chunk is uploaded per frame so the queue always makes progress.
+class UploadScheduler {
+    public:
+        UploadScheduler(float maxMillisPerFrame = UPLOAD_BUDGET_MS, size_t maxBytesPerFrame = UPLOAD_BUDGET_BYTES);
+
+        void push(Chunk* chunk);
+        // Uploads as many pending chunks as the budget allows, nearest to
+        // cameraPos first, and appends them to uploaded.
+        size_t process(const glm::vec3& cameraPos, std::vector<Chunk*>& uploaded);
+        // Moves pending chunks for which reject() is true into discarded
+        template <typename Predicate>
+        void discardIf(Predicate reject, std::vector<Chunk*>& discarded) {
+            size_t kept = 0;
+            for (Chunk* chunk : pending) {
+                if (reject(chunk)) {
+                    discarded.push_back(chunk);
+                } else {
+                    pending[kept++] = chunk;
+                }
+            }
+            pending.resize(kept);
+        }
+
+        size_t pendingCount() const { return pending.size(); }
+        size_t pendingBytes() const;   // RAM held by the pending chunks
+        size_t lastFrameBytes() const { return frameBytes; }
+
+        float maxMillisPerFrame;
+        size_t maxBytesPerFrame;
+
+    private:
+        std::vector<Chunk*> pending;
+        size_t frameBytes = 0;
+};
@@ -0,0 +1,355 @@
+#include "AllocTracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#if ALLOC_TRACKING
+#include <execinfo.h>
+#include <glad/glad.h>
+#endif
+
+namespace {
+    // Everything here is constant initialized and never allocates, it is
+    // used from inside operator new
+    struct ThreadSlot {
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> bytes;
+    };
+    ThreadSlot slots[AllocTracker::MAX_THREADS];
+    std::atomic<size_t> slotsUsed{0};
+    thread_local ThreadSlot* threadSlot = nullptr;
+
+#if ALLOC_TRACKING
+    struct Site {
+        uint64_t hash;   // 0 = empty
+        void* frames[AllocTracker::SAMPLE_DEPTH];
+        int depth;
+        uint64_t samples;
+        uint64_t bytes;
+    };
+    Site sites[AllocTracker::MAX_SAMPLED_SITES];
+    std::atomic_flag sitesLock = ATOMIC_FLAG_INIT;
+    std::atomic<uint32_t> sampleInterval{0};
+    thread_local uint32_t sampleCountdown = 0;
+    thread_local bool sampling = false;   // backtrace may allocate itself
+
+    // Every glGen* / glDelete* call goes through one of these
+    std::atomic<uint64_t> glObjectCalls{0};
+#define COUNTED_GL_CALL(function, Ids) \
+    decltype(glad_##function) real_##function = nullptr; \
+    void APIENTRY counted_##function(GLsizei n, Ids ids) { \
+        glObjectCalls.fetch_add(1, std::memory_order_relaxed); \
+        real_##function(n, ids); \
+    }
+    COUNTED_GL_CALL(glGenBuffers, GLuint*)
+    COUNTED_GL_CALL(glDeleteBuffers, const GLuint*)
+    COUNTED_GL_CALL(glGenVertexArrays, GLuint*)
+    COUNTED_GL_CALL(glDeleteVertexArrays, const GLuint*)
+    COUNTED_GL_CALL(glGenTextures, GLuint*)
+    COUNTED_GL_CALL(glDeleteTextures, const GLuint*)
+    COUNTED_GL_CALL(glGenFramebuffers, GLuint*)
+    COUNTED_GL_CALL(glDeleteFramebuffers, const GLuint*)
+    COUNTED_GL_CALL(glGenRenderbuffers, GLuint*)
+    COUNTED_GL_CALL(glDeleteRenderbuffers, const GLuint*)
+#undef COUNTED_GL_CALL
+#endif
+
+    // Main thread only
+    AllocTracker::Counts frameStartThread, frameStartAll;
+    uint64_t frameStartGlCalls = 0;
+    uint64_t frames = 0, steadyFrames = 0;
+    AllocTracker::Counts steadyThread, steadyAll, steadyRender, steadyStreaming, steadyOthers;
+    uint64_t maxThreadAllocations = 0, maxAllAllocations = 0, maxRenderAllocations = 0;
+    uint64_t maxStreamingAllocations = 0, maxOtherAllocations = 0;
+    uint64_t renderAllocatingFrames = 0, streamingAllocatingFrames = 0;
+    uint64_t steadyGlCalls = 0;
+
+    ThreadSlot& localSlot() {
+        if (threadSlot == nullptr) {
+            size_t index = slotsUsed.fetch_add(1, std::memory_order_relaxed);
+            threadSlot = &slots[index < AllocTracker::MAX_THREADS ? index : AllocTracker::MAX_THREADS - 1];
+        }
+        return *threadSlot;
+    }
+
+#if ALLOC_TRACKING
+    void sampleSite(size_t size) {
+        sampling = true;
+        void* frames[AllocTracker::SAMPLE_DEPTH + 2];
+        // Skip this function and operator new
+        int depth = std::max(0, backtrace(frames, AllocTracker::SAMPLE_DEPTH + 2) - 2);
+        uint64_t hash = 1469598103934665603ull;
+        for (int i = 0; i < depth; i++) {
+            hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i + 2])) * 1099511628211ull;
+        }
+        hash |= 1;
+
+        // Space saving: a new site takes over the least sampled one once the
+        // table is full, so the one off sites from startup don't keep the
+        // steady ones out
+        while (sitesLock.test_and_set(std::memory_order_acquire)) {
+        }
+        Site* found = nullptr;
+        Site* least = &sites[0];
+        for (Site& site : sites) {
+            if (site.hash == hash) {
+                found = &site;
+                break;
+            }
+            if (site.samples < least->samples) {
+                least = &site;
+            }
+        }
+        if (found == nullptr) {
+            found = least;
+            found->hash = hash;
+            std::copy(frames + 2, frames + 2 + depth, found->frames);
+            found->depth = depth;
+            found->bytes = 0;
+        }
+        found->samples++;
+        found->bytes += size;
+        sitesLock.clear(std::memory_order_release);
+        sampling = false;
+    }
+
+    void countAllocation(size_t size) {
+        ThreadSlot& slot = localSlot();
+        slot.allocations.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(size, std::memory_order_relaxed);
+        uint32_t interval = sampleInterval.load(std::memory_order_relaxed);
+        if (interval > 0 && !sampling && ++sampleCountdown >= interval) {
+            sampleCountdown = 0;
+            sampleSite(size);
+        }
+    }
+
+    void* allocate(size_t size) {
+        countAllocation(size);
+        return std::malloc(size > 0 ? size : 1);
+    }
+#endif
+}
+
+#if ALLOC_TRACKING
+// The aligned overloads are left alone: their default versions don't go
+// through these, and pair up with their own deletes
+void* operator new(std::size_t size) {
+    void* pointer = allocate(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+#endif
+
+AllocTracker::Counts AllocTracker::thisThread() {
+    ThreadSlot& slot = localSlot();
+    return {slot.allocations.load(std::memory_order_relaxed), slot.bytes.load(std::memory_order_relaxed)};
+}
+
+AllocTracker::Counts AllocTracker::allThreads() {
+    Counts total;
+    size_t used = slotsUsed.load(std::memory_order_relaxed);
+    used = used < MAX_THREADS ? used : MAX_THREADS;
+    for (size_t i = 0; i < used; i++) {
+        total.allocations += slots[i].allocations.load(std::memory_order_relaxed);
+        total.bytes += slots[i].bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void AllocTracker::setSampleInterval(uint32_t interval) {
+#if ALLOC_TRACKING
+    // The first backtrace call may load the unwinder, get that out of the way
+    void* frames[1];
+    sampling = true;
+    backtrace(frames, 1);
+    sampling = false;
+    sampleInterval.store(interval, std::memory_order_relaxed);
+#else
+    (void)interval;
+#endif
+}
+
+void AllocTracker::hookGlObjectCalls() {
+#if ALLOC_TRACKING
+#define HOOK_GL_CALL(function) \
+    real_##function = glad_##function; \
+    glad_##function = counted_##function;
+    HOOK_GL_CALL(glGenBuffers)
+    HOOK_GL_CALL(glDeleteBuffers)
+    HOOK_GL_CALL(glGenVertexArrays)
+    HOOK_GL_CALL(glDeleteVertexArrays)
+    HOOK_GL_CALL(glGenTextures)
+    HOOK_GL_CALL(glDeleteTextures)
+    HOOK_GL_CALL(glGenFramebuffers)
+    HOOK_GL_CALL(glDeleteFramebuffers)
+    HOOK_GL_CALL(glGenRenderbuffers)
+    HOOK_GL_CALL(glDeleteRenderbuffers)
+#undef HOOK_GL_CALL
+#endif
+}
+
+static uint64_t glCallsSoFar() {
+#if ALLOC_TRACKING
+    return glObjectCalls.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+void AllocTracker::beginFrame() {
+    frameStartThread = thisThread();
+    frameStartAll = allThreads();
+    frameStartGlCalls = glCallsSoFar();
+}
+
+void AllocTracker::endFrame(const Counts& render, const Counts& streaming) {
+    Counts thread = thisThread() - frameStartThread;
+    Counts all = allThreads() - frameStartAll;
+    Counts others = all - thread;
+    uint64_t glCalls = glCallsSoFar() - frameStartGlCalls;
+    if (frames++ < WARMUP_FRAMES) {
+#if ALLOC_TRACKING
+        // The sampled sites are about the steady state too
+        if (frames == WARMUP_FRAMES) {
+            while (sitesLock.test_and_set(std::memory_order_acquire)) {
+            }
+            for (Site& site : sites) {
+                site = Site();
+            }
+            sitesLock.clear(std::memory_order_release);
+        }
+#endif
+        return;
+    }
+    steadyFrames++;
+    steadyThread.allocations += thread.allocations;
+    steadyThread.bytes += thread.bytes;
+    steadyAll.allocations += all.allocations;
+    steadyAll.bytes += all.bytes;
+    steadyRender.allocations += render.allocations;
+    steadyRender.bytes += render.bytes;
+    maxThreadAllocations = std::max(maxThreadAllocations, thread.allocations);
+    maxAllAllocations = std::max(maxAllAllocations, all.allocations);
+    maxRenderAllocations = std::max(maxRenderAllocations, render.allocations);
+    if (render.allocations > 0) {
+        renderAllocatingFrames++;
+    }
+    steadyStreaming.allocations += streaming.allocations;
+    steadyStreaming.bytes += streaming.bytes;
+    steadyOthers.allocations += others.allocations;
+    steadyOthers.bytes += others.bytes;
+    maxStreamingAllocations = std::max(maxStreamingAllocations, streaming.allocations);
+    maxOtherAllocations = std::max(maxOtherAllocations, others.allocations);
+    if (streaming.allocations > 0 || others.allocations > 0) {
+        streamingAllocatingFrames++;
+    }
+    steadyGlCalls += glCalls;
+}
+
+uint64_t AllocTracker::steadyRenderAllocations() {
+    return steadyRender.allocations;
+}
+
+uint64_t AllocTracker::steadyStreamingAllocations() {
+    return steadyStreaming.allocations + steadyOthers.allocations;
+}
+
+uint64_t AllocTracker::steadyGlObjectCalls() {
+    return steadyGlCalls;
+}
+
+void AllocTracker::printSummary() {
+    if (!enabled()) {
+        printf("allocations: not tracked, build with ALLOC_TRACKING=1\n");
+        return;
+    }
+    if (steadyFrames > 0) {
+        printf("allocations/frame after %llu warmup frames (%llu frames)     mean   bytes    max\n",
+               static_cast<unsigned long long>(WARMUP_FRAMES), static_cast<unsigned long long>(steadyFrames));
+        const char* labels[5] = {"main thread", "all threads", "Game::Render", "UpdateChunks", "other threads"};
+        const Counts* sums[5] = {&steadyThread, &steadyAll, &steadyRender, &steadyStreaming, &steadyOthers};
+        uint64_t maxima[5] = {maxThreadAllocations, maxAllAllocations, maxRenderAllocations, maxStreamingAllocations, maxOtherAllocations};
+        for (int i = 0; i < 5; i++) {
+            printf("  %-14s %8.1f %8llu %6llu\n", labels[i], static_cast<double>(sums[i]->allocations) / steadyFrames,
+                   static_cast<unsigned long long>(sums[i]->bytes / steadyFrames), static_cast<unsigned long long>(maxima[i]));
+        }
+        printf("  frames where Game::Render allocated: %llu, streaming allocated: %llu\n",
+               static_cast<unsigned long long>(renderAllocatingFrames), static_cast<unsigned long long>(streamingAllocatingFrames));
+        printf("  glGen/glDelete calls after the warmup: %llu\n", static_cast<unsigned long long>(steadyGlCalls));
+    }
+    size_t used = slotsUsed.load(std::memory_order_relaxed);
+    used = used < MAX_THREADS ? used : MAX_THREADS;
+    for (size_t i = 0; i < used; i++) {
+        printf("  thread %zu: %llu allocations, %llu KB\n", i,
+               static_cast<unsigned long long>(slots[i].allocations.load(std::memory_order_relaxed)),
+               static_cast<unsigned long long>(slots[i].bytes.load(std::memory_order_relaxed) / 1024));
+    }
+
+#if ALLOC_TRACKING
+    // Most sampled call sites; symbol lookup allocates, so keep it out of the samples
+    while (sitesLock.test_and_set(std::memory_order_acquire)) {
+    }
+    static Site top[MAX_SAMPLED_SITES];
+    size_t siteCount = 0;
+    for (const Site& site : sites) {
+        if (site.hash != 0) {
+            top[siteCount++] = site;
+        }
+    }
+    sitesLock.clear(std::memory_order_release);
+    size_t topCount = siteCount < 10 ? siteCount : 10;
+    std::partial_sort(top, top + topCount, top + siteCount, [](const Site& a, const Site& b) { return a.samples > b.samples; });
+    sampling = true;
+    for (size_t i = 0; i < topCount; i++) {
+        printf("sampled site %zu: %llu samples, %llu bytes\n", i, static_cast<unsigned long long>(top[i].samples),
+               static_cast<unsigned long long>(top[i].bytes));
+        char** symbols = backtrace_symbols(top[i].frames, top[i].depth);
+        for (int frame = 0; symbols != nullptr && frame < top[i].depth; frame++) {
+            printf("    %s\n", symbols[frame]);
+        }
+        std::free(symbols);
+    }
+    sampling = false;
+#endif
+    fflush(stdout);
+}
@@ -0,0 +1,105 @@
+#include "BufferSubAllocator.hpp"
+#include <algorithm>
+
+BufferSubAllocator::BufferSubAllocator(uint32_t capacity) {
+    reset(capacity);
+}
+
+void BufferSubAllocator::reset(uint32_t capacity) {
+    freeBlocks.clear();
+    totalCapacity = capacity;
+    freeTotal = capacity;
+    if (capacity > 0) {
+        freeBlocks[0] = capacity;
+    }
+}
+
+void BufferSubAllocator::grow(uint32_t capacity) {
+    if (capacity <= totalCapacity) {
+        return;
+    }
+    uint32_t oldCapacity = totalCapacity;
+    totalCapacity = capacity;
+    free(oldCapacity, capacity - oldCapacity);
+}
+
+void BufferSubAllocator::reserveBlocks(size_t count) {
+    warmRecycledNodes<FreeBlockMap>(count, [](size_t i) { return std::make_pair(static_cast<uint32_t>(i), 0u); });
+}
+
+uint32_t BufferSubAllocator::allocate(uint32_t size) {
+    if (size == 0) {
+        return INVALID_OFFSET;
+    }
+    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+        if (it->second >= size) {
+            uint32_t offset = it->first;
+            uint32_t remaining = it->second - size;
+            freeBlocks.erase(it);
+            if (remaining > 0) {
+                freeBlocks[offset + size] = remaining;
+            }
+            freeTotal -= size;
+            return offset;
+        }
+    }
+    return INVALID_OFFSET;
+}
+
+void BufferSubAllocator::free(uint32_t offset, uint32_t size) {
+    if (size == 0 || offset == INVALID_OFFSET) {
+        return;
+    }
+    freeTotal += size;
+    auto next = freeBlocks.lower_bound(offset);
+
+    // Merge with the block before us
+    if (next != freeBlocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            freeBlocks.erase(prev);
+        }
+    }
+    // and the one after
+    if (next != freeBlocks.end() && offset + size == next->first) {
+        size += next->second;
+        freeBlocks.erase(next);
+    }
+    freeBlocks[offset] = size;
+}
+
+bool BufferSubAllocator::resize(uint32_t offset, uint32_t oldSize, uint32_t newSize) {
+    if (newSize <= oldSize) {
+        free(offset + newSize, oldSize - newSize);
+        return true;
+    }
+    uint32_t extra = newSize - oldSize;
+    auto next = freeBlocks.find(offset + oldSize);
+    if (next == freeBlocks.end() || next->second < extra) {
+        return false;
+    }
+    uint32_t remaining = next->second - extra;
+    freeBlocks.erase(next);
+    if (remaining > 0) {
+        freeBlocks[offset + newSize] = remaining;
+    }
+    freeTotal -= extra;
+    return true;
+}
+
+uint32_t BufferSubAllocator::largestFreeBlock() const {
+    uint32_t largest = 0;
+    for (const auto& block : freeBlocks) {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
+
+float BufferSubAllocator::fragmentation() const {
+    if (freeTotal == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(largestFreeBlock()) / static_cast<float>(freeTotal);
+}
@@ -1,4 +1,5 @@
 #include "Camera.hpp"
+#include "Log.hpp"
 #include <iostream>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -85,6 +86,13 @@ void Camera::updateCameraVectors()
         cameraUp = glm::normalize(glm::cross(cameraRight, cameraFront));
     }
 
+void Camera::setPose(const glm::vec3& position, float yaw, float pitch) {
+    cameraPos = position;
+    Yaw = yaw;
+    Pitch = pitch;
+    updateCameraVectors();
+}
+
 void Camera::processInput(Camera_Movement direction, float deltaTime){
     float velocity = MovementSpeed * deltaTime;
         if (direction == FORWARD)
@@ -138,23 +146,23 @@ void Camera::initRayRendering() {
 }
 
 void Camera::render(GLuint shaderProgram, float rayLength) {
-    std::cout << "Rendering ray" << std::endl;
+    LOG_TRACE("Rendering ray");
     glUseProgram(shaderProgram);
     checkGLError("render: After glUseProgram");
 
     // Calculate the start (camera position) and end of the ray (cameraFront * length)
     glm::vec3 rayEnd = cameraPos + cameraFront * 100.0f;  // Keep the ray length minimal for testing
-    cout << cameraPos.x << ", " << cameraPos.y << ", " << cameraPos.z << endl;
-    cout << cameraFront.x << ", " << cameraFront.y << ", " << cameraFront.z << endl;
-    cout << rayEnd.x << ", " << rayEnd.y << ", " << rayEnd.z << endl;
+    LOG_TRACE(cameraPos.x, ", ", cameraPos.y, ", ", cameraPos.z);
+    LOG_TRACE(cameraFront.x, ", ", cameraFront.y, ", ", cameraFront.z);
+    LOG_TRACE(rayEnd.x, ", ", rayEnd.y, ", ", rayEnd.z);
 
     // Define the ray vertices
     glm::vec3 vertices[2] = { cameraPos, rayEnd };  // Simple line in front of the camera
 
     // glm::vec3 vertices[2] = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -5.0f) };  // Simple line in front of the camera
     
-    cout << "Ray Start: " << cameraPos.x << ", " << cameraPos.y << ", " << cameraPos.z << endl;
-    cout << "Ray End: " << rayEnd.x << ", " << rayEnd.y << ", " << rayEnd.z << endl;
+    LOG_TRACE("Ray Start: ", cameraPos.x, ", ", cameraPos.y, ", ", cameraPos.z);
+    LOG_TRACE("Ray End: ", rayEnd.x, ", ", rayEnd.y, ", ", rayEnd.z);
 
     // Update the VBO with the new ray vertices
     glBindBuffer(GL_ARRAY_BUFFER, rayVBO);
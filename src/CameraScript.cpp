@@ -0,0 +1,115 @@
+#include "CameraScript.hpp"
+#include "TerrainNoise.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+CameraScript::CameraScript() : worldSeed(TERRAIN_SEED) {
+    useDefaultFlight();
+}
+
+void CameraScript::useDefaultFlight() {
+    // Above the highest surface, looking down a little, so streaming,
+    // culling and the horizon all get exercised. Turns in place at the corners.
+    const float HEIGHT = 28.0f;
+    const float PITCH = -20.0f;
+    keyframes = {
+        { 0.0f, glm::vec3( 0.0f, HEIGHT,  0.0f),   0.0f, PITCH},
+        { 5.0f, glm::vec3(96.0f, HEIGHT,  0.0f),   0.0f, PITCH},
+        { 6.0f, glm::vec3(96.0f, HEIGHT,  0.0f),  90.0f, PITCH},
+        {11.0f, glm::vec3(96.0f, HEIGHT, 96.0f),  90.0f, PITCH},
+        {12.0f, glm::vec3(96.0f, HEIGHT, 96.0f), 180.0f, PITCH},
+        {17.0f, glm::vec3( 0.0f, HEIGHT, 96.0f), 180.0f, PITCH},
+        {18.0f, glm::vec3( 0.0f, HEIGHT, 96.0f), 270.0f, PITCH},
+        {23.0f, glm::vec3( 0.0f, HEIGHT,  0.0f), 270.0f, PITCH},
+    };
+}
+
+bool CameraScript::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "CameraScript: can't open " << path << std::endl;
+        return false;
+    }
+    std::vector<Keyframe> loaded;
+    uint32_t loadedSeed = TERRAIN_SEED;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(line);
+        if (line.compare(line.find_first_not_of(" \t"), 4, "seed") == 0) {
+            std::string keyword;
+            if (!(fields >> keyword >> loadedSeed)) {
+                std::cerr << "CameraScript: " << path << ":" << lineNumber << " is not \"seed N\"" << std::endl;
+                return false;
+            }
+            continue;
+        }
+        Keyframe keyframe;
+        if (!(fields >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch)) {
+            std::cerr << "CameraScript: " << path << ":" << lineNumber << " is not \"time x y z yaw pitch\"" << std::endl;
+            return false;
+        }
+        loaded.push_back(keyframe);
+    }
+    if (loaded.empty()) {
+        std::cerr << "CameraScript: " << path << " has no keyframes" << std::endl;
+        return false;
+    }
+    std::stable_sort(loaded.begin(), loaded.end(), [](const Keyframe& a, const Keyframe& b) { return a.time < b.time; });
+    keyframes = loaded;
+    worldSeed = loadedSeed;
+    return true;
+}
+
+bool CameraScript::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "CameraScript: can't write " << path << std::endl;
+        return false;
+    }
+    file.precision(8);
+    file << "# time x y z yaw pitch\n";
+    file << "seed " << worldSeed << "\n";
+    for (const Keyframe& keyframe : keyframes) {
+        file << keyframe.time << " " << keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z
+             << " " << keyframe.yaw << " " << keyframe.pitch << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+void CameraScript::addKeyframe(float time, const glm::vec3& position, float yaw, float pitch) {
+    keyframes.push_back({time, position, yaw, pitch});
+}
+
+void CameraScript::sample(float time, glm::vec3& position, float& yaw, float& pitch) const {
+    float length = duration();
+    if (length > 0.0f) {
+        time = std::fmod(std::max(time, 0.0f), length);
+    }
+    // First keyframe after time, the one before it is where we come from
+    size_t next = 0;
+    while (next < keyframes.size() && keyframes[next].time <= time) {
+        next++;
+    }
+    if (next == 0 || next == keyframes.size()) {
+        const Keyframe& only = keyframes[next == 0 ? 0 : next - 1];
+        position = only.position;
+        yaw = only.yaw;
+        pitch = only.pitch;
+        return;
+    }
+    const Keyframe& from = keyframes[next - 1];
+    const Keyframe& to = keyframes[next];
+    float t = (time - from.time) / (to.time - from.time);
+    position = glm::mix(from.position, to.position, t);
+    yaw = from.yaw + (to.yaw - from.yaw) * t;
+    pitch = from.pitch + (to.pitch - from.pitch) * t;
+}
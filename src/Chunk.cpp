@@ -1,11 +1,54 @@
 #include "Chunk.hpp"
+#include "TerrainNoise.hpp"
+#include "Profiler.hpp"
+#include "Log.hpp"
+#include "FrameStats.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 using namespace std;
 
+MeshFormat Chunk::meshFormat = MeshFormat::Vertices;
+
+// The scratch mesh is sized for this many quads up front (the busiest full
+// detail chunks on the flights have about 1600), so a worker that has only
+// meshed coarse chunks so far doesn't grow it on its first full one
+#define SCRATCH_MESH_QUADS 2048
+
+// Outward normal of each Face, in Face order
+static const glm::ivec3 FACE_NORMALS[6] = {{0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+
+// The mesher's other per thread buffers, kept between chunks like
+// MeshData::threadScratch so a warmed up worker doesn't touch the heap
+struct WorkerScratch {
+    std::vector<uint8_t> filled;        // computeConnectivity
+    std::vector<glm::ivec3> stack;
+    std::vector<BlockType> mask;        // generateLodMesh
+    // Full size grid a coarse chunk is generated into before it's downsampled
+    std::vector<std::vector<std::vector<BlockType>>> voxels;
+
+    size_t capacityBytes() const {
+        size_t voxelBytes = voxels.empty() ? 0 : voxels.size() * voxels[0].size() * (sizeof(std::vector<BlockType>) + voxels[0][0].size() * sizeof(BlockType));
+        return filled.capacity() * sizeof(uint8_t) + stack.capacity() * sizeof(glm::ivec3)
+             + mask.capacity() * sizeof(BlockType) + voxelBytes;
+    }
+};
+static thread_local WorkerScratch workerScratch;
+
+// Reports how much this thread's WorkerScratch grew since the last call
+static void trackWorkerScratchGrowth() {
+    thread_local size_t counted = 0;
+    size_t bytes = workerScratch.capacityBytes();
+    if (bytes != counted) {
+        MemoryStats::track(MemoryCategory::MesherScratch, static_cast<long long>(bytes) - static_cast<long long>(counted));
+        counted = bytes;
+    }
+}
+
 GLenum err;
 #define CHECK_GL_ERROR() \
     while ((err = glGetError()) != GL_NO_ERROR) { \
@@ -15,29 +58,79 @@ GLenum err;
 
 
 
-Chunk::Chunk(int sizeX, int sizeY, int sizeZ, glm::vec3 position , Game *gameRef, GLuint shaderProgram, TextureManager& textureManager) :
-    sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), position(position), gameRef(gameRef), shaderProgram(shaderProgram), textureManager(textureManager) {
+Chunk::Chunk(int sizeX, int sizeY, int sizeZ, glm::vec3 position , Game *gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel) :
+    lodLevel(lodLevel), textureManager(textureManager), sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), position(position), gameRef(gameRef), shaderProgram(shaderProgram) {
     // Load shaders
     // this->sizeX = sizeX;
     // this->sizeY = sizeY;
     // this->sizeZ = sizeZ;
 
-    voxels = std::vector<std::vector<std::vector<BlockType>>>(sizeX, std::vector<std::vector<BlockType>>(sizeY, std::vector<BlockType>(sizeZ)));
-    //initialize voxels
+    allocateStorage();
     
     // cout << "Creating chunk for sizes" << sizeX << sizeY << sizeX <<  "at position" << position.x << position.y << position.z << endl;
     // loadShaders("VertShader.vertexshader", "FragShader.fragmentshader");
+    build();
+    // setupMesh();
+}
+
+Chunk::Chunk(int sizeX, int sizeY, int sizeZ, Game *gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel) :
+    lodLevel(lodLevel), textureManager(textureManager), sizeX(sizeX), sizeY(sizeY), sizeZ(sizeZ), position(0.0f), gameRef(gameRef), shaderProgram(shaderProgram) {
+    allocateStorage();
+}
+
+void Chunk::allocateStorage() {
+    if (lodLevel == 0) {
+        allocateVoxels(voxels);
+    } else {
+        lodCells.reserve(static_cast<size_t>(std::max(1, sizeX / 2)) * std::max(1, sizeY / 2) * std::max(1, sizeZ / 2));  // level 1's
+    }
+    // Two corners per quarter, sized up front so a pooled chunk that was first
+    // meshed at a coarse level doesn't grow it later
+    occluderBoxes.reserve(8);
+}
+
+void Chunk::allocateVoxels(std::vector<std::vector<std::vector<BlockType>>>& grid) const {
+    if (grid.size() != static_cast<size_t>(sizeX) || grid[0].size() != static_cast<size_t>(sizeY) || grid[0][0].size() != static_cast<size_t>(sizeZ)) {
+        grid = std::vector<std::vector<std::vector<BlockType>>>(sizeX, std::vector<std::vector<BlockType>>(sizeY, std::vector<BlockType>(sizeZ)));
+    }
+}
+
+void Chunk::build() {
+    // A coarse chunk borrows this thread's full size grid to generate and
+    // downsample from, then hands it back
+    bool coarse = lodLevel > 0;
+    if (coarse) {
+        if (workerScratch.voxels.empty()) {
+            workerScratch.voxels.swap(voxels);   // a pooled level 0 chunk's grid will do
+        }
+        allocateVoxels(workerScratch.voxels);
+        voxels.swap(workerScratch.voxels);
+    } else {
+        allocateVoxels(voxels);   // a pooled coarse chunk that is now level 0
+    }
     initChunk();
+    trace.stamp(ChunkStage::Generated, FrameStats::nowSeconds());
     generateChunk();
-    // setupMesh();
+    trace.stamp(ChunkStage::Meshed, FrameStats::nowSeconds());
+    if (coarse) {
+        voxels.swap(workerScratch.voxels);
+        voxels = std::vector<std::vector<std::vector<BlockType>>>();   // only the cells are kept
+    }
+}
+
+void Chunk::reset(glm::vec3 position, int lodLevel) {
+    this->position = position;
+    this->lodLevel = lodLevel;
+    releaseStagedMesh();
+    mesh = nullptr;
+    trace = ChunkTrace();
+    build();
 }
 
 Chunk::~Chunk() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteBuffers(1, &TBO);
-    glDeleteProgram(shaderProgram);
+    releaseStagedMesh();
+    releaseMesh();
+    // shaderProgram is shared by every chunk, the Game owns it
 }
 
 void Chunk::loadShaders(const std::string& vertexPath, const std::string& fragmentPath){
@@ -89,8 +182,8 @@ void Chunk::loadShaders(const std::string& vertexPath, const std::string& fragme
     // cout << "Loaded shaders" << endl;
 }
 void Chunk::initChunk() {
-    unsigned int seed = 1234;  // Use a consistent seed
-    siv::PerlinNoise perlinNoise(seed);
+    PROFILE_ZONE("Chunk::initChunk");
+    const siv::PerlinNoise& perlinNoise = terrainNoise();
     int maxHeight = sizeY*0.5;
 
     for (int x = 0; x < sizeX; x++) {
@@ -98,47 +191,11 @@ void Chunk::initChunk() {
             int worldX = static_cast<int>(position.x) + x;
             int worldZ = static_cast<int>(position.z) + z;
 
-            // Biome noise calculation
-            float biomeFrequency = 0.02f;
-            float biomeAmplitude = 1.0f;
-            float biomePersistence = 0.5f;
-            int biomeOctaves = 4;
-            float biomeNoise = 0.0f;
-            float maxBiomeAmplitude = 0.0f;
-            float currentBiomeFrequency = biomeFrequency;
-            float currentBiomeAmplitude = biomeAmplitude;
-
-            for (int i = 0; i < biomeOctaves; i++) {
-                biomeNoise += perlinNoise.noise2D_01(worldX * currentBiomeFrequency, worldZ * currentBiomeFrequency) * currentBiomeAmplitude;
-                maxBiomeAmplitude += currentBiomeAmplitude;
-                currentBiomeAmplitude *= biomePersistence;
-                currentBiomeFrequency *= 2.0f;
-            }
-
-            biomeNoise /= maxBiomeAmplitude; // Normalize to [0, 1]
-            biomeNoise = biomeNoise * 2.0f - 1.0f; // Map to [-1, 1]
-
-            BiomeType biome = determineBiome(biomeNoise);
-            BiomeProperties properties = biomeProperties[biome];
-
-            // Terrain height calculation
-            float frequency = 0.01f;
-            float amplitude = 80.0f * properties.terrainRoughness;  // Increased amplitude
-            float terrainNoise = 0.0f;
-            float persistence = 0.5f;
-            int octaves = 4;
-
-            float currentAmplitude = amplitude;
-            float currentFrequency = frequency;
-
-            for (int i = 0; i < octaves; i++) {
-                terrainNoise += perlinNoise.noise2D_01(worldX * currentFrequency, worldZ * currentFrequency) * currentAmplitude;
-                currentAmplitude *= persistence;
-                currentFrequency *= 2.0f;
-            }
-
-            terrainNoise = glm::clamp(terrainNoise, 0.0f, (float)(maxHeight - 1));
-            int surfaceHeight = static_cast<int>(terrainNoise);
+            // Biome and surface height come from the 2D noise shared with the horizon
+            SurfaceSample surface = sampleSurface(perlinNoise, worldX, worldZ, maxHeight);
+            BiomeType biome = surface.biome;
+            BiomeProperties properties = biomeProperties.at(biome);
+            int surfaceHeight = surface.height;
 
             // Initialize all voxels to Air
             for (int y = 0; y < sizeY; y++) {
@@ -168,7 +225,7 @@ void Chunk::initChunk() {
             }
 
             // Tree placement
-            if (biomeSupportsTrees(biome) && rand() % 100 < properties.treeProbability) {
+            if (biomeSupportsTrees(biome) && columnHash(worldX, worldZ) % 100 < static_cast<uint32_t>(properties.treeProbability)) {
                 placeTree(x, surfaceHeight + 1, z);
             }
         }
@@ -177,46 +234,247 @@ void Chunk::initChunk() {
 
 
 void Chunk::generateChunk(){
-    vertices.clear();
-    indices.clear();
-    texCoordsArray.clear();
+    PROFILE_ZONE("Chunk::generateChunk");
+    mesh = &MeshData::threadScratch();
+    mesh->clear();
+    mesh->reserveQuads(SCRATCH_MESH_QUADS, meshFormat);
+    if (lodLevel > 0) {
+        generateLodMesh(1 << lodLevel);
+        occluderBoxes.clear();  // the coarse surface may sit below the real one
+        computeConnectivity();
+        return;
+    }
     
     // cout << "Generating chunk for sizes" << sizeX << sizeX << endl;
-    for (int x = 0; x < sizeX; x++){
-        for (int z = 0; z < sizeZ; z++){
-            for (int y = 0; y < sizeY; y++){
-                
-                // Only process solid voxels
-                if (voxels[x][y][z] != BlockType::Air) {
-                    glm::vec3 pos = glm::vec3(x, y, z);
-
-                   
-                    // Face culling logic: only add the face if it's adjacent to air or chunk boundary
-                    if (y == sizeY - 1 || !isVoxelSolid(x, y + 1, z)) {  // Top face
-                        addFace(pos, Face::top);
+    // One pass per face direction, in Face order, so every direction's faces
+    // come out as one contiguous range (see MeshData::directionQuads)
+    for (int faceIndex = 0; faceIndex < 6; faceIndex++) {
+        Face face = static_cast<Face>(faceIndex);
+        glm::ivec3 normal = FACE_NORMALS[faceIndex];
+        for (int x = 0; x < sizeX; x++){
+            for (int z = 0; z < sizeZ; z++){
+                for (int y = 0; y < sizeY; y++){
+
+                    // Only process solid voxels
+                    if (voxels[x][y][z] != BlockType::Air) {
+                        // Face culling logic: only add the face if it's adjacent to air or chunk boundary
+                        glm::ivec3 n = glm::ivec3(x, y, z) + normal;
+                        bool border = n.x < 0 || n.y < 0 || n.z < 0 || n.x >= sizeX || n.y >= sizeY || n.z >= sizeZ;
+                        if (border || !isVoxelSolid(n.x, n.y, n.z)) {
+                            addFace(glm::vec3(x, y, z), face);
+                        }
                     }
-                    if (y == 0 || !isVoxelSolid(x, y - 1, z)) {  // Bottom face
-                        addFace(pos, Face::bottom);
+                }
+            }
+        }
+    }
+    computeOccluders();
+    computeConnectivity();
+}
+
+void Chunk::generateLodMesh(int step) {
+    // Downsample: a cell is solid when at least half its voxels are, and
+    // shows the block of its highest solid voxel so grass stays grass
+    int nx = std::max(1, sizeX / step), ny = std::max(1, sizeY / step), nz = std::max(1, sizeZ / step);
+    std::vector<BlockType>& cells = lodCells;
+    cells.assign(nx * ny * nz, BlockType::Air);
+    auto cellAt = [&](int x, int y, int z) { return cells[(x * ny + y) * nz + z]; };
+    for (int cx = 0; cx < nx; cx++) {
+        for (int cy = 0; cy < ny; cy++) {
+            for (int cz = 0; cz < nz; cz++) {
+                int solid = 0, topY = -1;
+                BlockType top = BlockType::Air;
+                for (int x = cx * step; x < (cx + 1) * step; x++) {
+                    for (int y = cy * step; y < (cy + 1) * step; y++) {
+                        for (int z = cz * step; z < (cz + 1) * step; z++) {
+                            if (voxels[x][y][z] != BlockType::Air) {
+                                solid++;
+                                if (y > topY) {
+                                    topY = y;
+                                    top = voxels[x][y][z];
+                                }
+                            }
+                        }
                     }
-                    if (x == sizeX - 1 || !isVoxelSolid(x + 1, y, z)) {  // Right face
-                        addFace(pos, Face::right);
+                }
+                if (solid * 2 >= step * step * step) {
+                    cells[(cx * ny + cy) * nz + cz] = top;
+                }
+            }
+        }
+    }
+
+    // Greedy meshing: for every face direction and every slice of cells,
+    // merge neighbouring visible faces with the same texture into rectangles.
+    // Faces on the chunk border are always emitted, which closes the chunk
+    // off with walls: they are the skirts that hide cracks against
+    // neighbours meshed at another level.
+    const glm::ivec3 size(nx, ny, nz);
+    std::vector<BlockType>& mask = workerScratch.mask;
+    for (int faceIndex = 0; faceIndex < 6; faceIndex++) {
+        Face face = static_cast<Face>(faceIndex);
+        glm::ivec3 normal = FACE_NORMALS[faceIndex];
+        int d = normal.x != 0 ? 0 : (normal.y != 0 ? 1 : 2);
+        int u = (d + 1) % 3, v = (d + 2) % 3;
+        mask.assign(size[u] * size[v], BlockType::Air);
+
+        for (int slice = 0; slice < size[d]; slice++) {
+            for (int i = 0; i < size[u]; i++) {
+                for (int j = 0; j < size[v]; j++) {
+                    glm::ivec3 c;
+                    c[d] = slice;
+                    c[u] = i;
+                    c[v] = j;
+                    BlockType block = cellAt(c.x, c.y, c.z);
+                    glm::ivec3 n = c + normal;
+                    bool open = n[d] < 0 || n[d] >= size[d] || cellAt(n.x, n.y, n.z) == BlockType::Air;
+                    mask[i * size[v] + j] = block != BlockType::Air && open ? getBlockTextureType(block, face) : BlockType::Air;
+                }
+            }
+            for (int i = 0; i < size[u]; i++) {
+                for (int j = 0; j < size[v];) {
+                    BlockType texture = mask[i * size[v] + j];
+                    if (texture == BlockType::Air) {
+                        j++;
+                        continue;
                     }
-                    if (x == 0 || !isVoxelSolid(x - 1, y, z)) {  // Left face
-                        addFace(pos, Face::left);
+                    int width = 1;
+                    while (j + width < size[v] && mask[i * size[v] + j + width] == texture) {
+                        width++;
                     }
-                    if (z == sizeZ - 1 || !isVoxelSolid(x, y, z + 1)) {  // Front face
-                        addFace(pos, Face::front);
+                    int height = 1;
+                    bool grow = true;
+                    while (i + height < size[u] && grow) {
+                        for (int k = 0; k < width && grow; k++) {
+                            grow = mask[(i + height) * size[v] + j + k] == texture;
+                        }
+                        if (grow) {
+                            height++;
+                        }
                     }
-                    if (z == 0 || !isVoxelSolid(x, y, z - 1)) {  // Back face
-                        addFace(pos, Face::back);
+                    for (int a = 0; a < height; a++) {
+                        for (int b = 0; b < width; b++) {
+                            mask[(i + a) * size[v] + j + b] = BlockType::Air;
+                        }
                     }
+
+                    glm::ivec3 first, last;
+                    first[d] = last[d] = slice;
+                    first[u] = i;
+                    last[u] = i + height - 1;
+                    first[v] = j;
+                    last[v] = j + width - 1;
+                    glm::vec3 lo = glm::vec3(first * step) - glm::vec3(0.5f);
+                    glm::vec3 hi = glm::vec3((last + glm::ivec3(1)) * step) - glm::vec3(0.5f);
+                    // Texture block types map to themselves in getBlockTextureType
+                    addQuad(lo, hi, face, texture);
+                    j += width;
                 }
             }
         }
     }
 }
+
+void Chunk::computeConnectivity() {
+    // Flood fill every pocket of see-through voxels and note which chunk
+    // faces it touches; all faces a pocket touches can see each other
+    faceConnections = 0;
+    std::vector<uint8_t>& filled = workerScratch.filled;
+    std::vector<glm::ivec3>& stack = workerScratch.stack;
+    filled.assign(sizeX * sizeY * sizeZ, 0);
+    stack.clear();
+    stack.reserve(filled.size());   // a voxel is pushed at most once
+    auto seeThrough = [this](int x, int y, int z) {
+        BlockType block = voxels[x][y][z];
+        return block == BlockType::Air || block == BlockType::Leaves;
+    };
+    auto index = [this](int x, int y, int z) { return (x * sizeY + y) * sizeZ + z; };
+
+    for (int x = 0; x < sizeX; x++) {
+        for (int y = 0; y < sizeY; y++) {
+            for (int z = 0; z < sizeZ; z++) {
+                if (filled[index(x, y, z)] || !seeThrough(x, y, z)) {
+                    continue;
+                }
+                unsigned int touched = 0;
+                filled[index(x, y, z)] = 1;
+                stack.push_back(glm::ivec3(x, y, z));
+                while (!stack.empty()) {
+                    glm::ivec3 v = stack.back();
+                    stack.pop_back();
+                    if (v.x == 0) touched |= 1u << Face::left;
+                    if (v.x == sizeX - 1) touched |= 1u << Face::right;
+                    if (v.y == 0) touched |= 1u << Face::bottom;
+                    if (v.y == sizeY - 1) touched |= 1u << Face::top;
+                    if (v.z == 0) touched |= 1u << Face::back;
+                    if (v.z == sizeZ - 1) touched |= 1u << Face::front;
+
+                    const glm::ivec3 steps[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+                    for (const glm::ivec3& step : steps) {
+                        glm::ivec3 n = v + step;
+                        if (n.x < 0 || n.y < 0 || n.z < 0 || n.x >= sizeX || n.y >= sizeY || n.z >= sizeZ) {
+                            continue;
+                        }
+                        if (!filled[index(n.x, n.y, n.z)] && seeThrough(n.x, n.y, n.z)) {
+                            filled[index(n.x, n.y, n.z)] = 1;
+                            stack.push_back(n);
+                        }
+                    }
+                }
+                for (int a = 0; a < 6; a++) {
+                    if (touched & (1u << a)) {
+                        for (int b = 0; b < 6; b++) {
+                            if (touched & (1u << b)) {
+                                faceConnections |= 1ull << (a * 6 + b);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Chunk::computeOccluders() {
+    // One box per quarter of the chunk: the tallest run of layers that are
+    // solid all the way across that quarter. Caves and uneven surfaces just
+    // make the boxes smaller. Leaves can be seen through, they don't count.
+    occluderBoxes.clear();
+    int halfX = std::max(1, sizeX / 2), halfZ = std::max(1, sizeZ / 2);
+    for (int qx = 0; qx < sizeX; qx += halfX) {
+        for (int qz = 0; qz < sizeZ; qz += halfZ) {
+            int endX = std::min(sizeX, qx + halfX), endZ = std::min(sizeZ, qz + halfZ);
+            int bestStart = 0, bestLength = 0, runStart = 0;
+            for (int y = 0; y <= sizeY; y++) {
+                bool layerSolid = y < sizeY;
+                for (int x = qx; x < endX && layerSolid; x++) {
+                    for (int z = qz; z < endZ && layerSolid; z++) {
+                        BlockType block = voxels[x][y][z];
+                        layerSolid = block != BlockType::Air && block != BlockType::Leaves;
+                    }
+                }
+                if (!layerSolid) {
+                    if (y - runStart > bestLength) {
+                        bestStart = runStart;
+                        bestLength = y - runStart;
+                    }
+                    runStart = y + 1;
+                }
+            }
+            if (bestLength > 0) {
+                occluderBoxes.push_back(position + glm::vec3(qx, bestStart, qz) - glm::vec3(0.5f));
+                occluderBoxes.push_back(position + glm::vec3(endX, bestStart + bestLength, endZ) - glm::vec3(0.5f));
+            }
+        }
+    }
+}
 void Chunk::addFace(const glm::vec3& pos, Face face) {
-    BlockType blockType = voxels[pos.x][pos.y][pos.z];
+    addQuad(pos - glm::vec3(0.5f), pos + glm::vec3(0.5f), face, voxels[pos.x][pos.y][pos.z]);
+}
+
+// Face of the box lo..hi. The texture is stretched over the whole quad, so
+// merged LOD quads show one block's texture rather than a repeating one.
+void Chunk::addQuad(const glm::vec3& lo, const glm::vec3& hi, Face face, BlockType blockType) {
     glm::vec2 texCoords[4];
     float textureSize = 16.0f / 256.0f;  // Each sprite is 16x16 in a 256x256 texture atlas
 
@@ -224,6 +482,18 @@ void Chunk::addFace(const glm::vec3& pos, Face face) {
     glm::vec2 spriteCoords = blockTypeToTextureCoords[textureBlockType];
     int spriteX = static_cast<int>(spriteCoords.x);
     int spriteY = static_cast<int>(spriteCoords.y);
+    mesh->directionQuads[face]++;
+
+    if (meshFormat == MeshFormat::FaceRecords) {
+        // The box and texture tile is all VertShaderFaces needs to rebuild the quad
+        glm::ivec3 low = glm::ivec3(lo + glm::vec3(0.5f));
+        glm::ivec3 size = glm::ivec3(hi - lo + glm::vec3(0.5f)) - glm::ivec3(1);
+        FaceRecord record;
+        record.box = low.x | low.y << 4 | low.z << 8 | size.x << 12 | size.y << 16 | size.z << 20 | static_cast<uint32_t>(face) << 24;
+        record.sprite = spriteX | spriteY << 4;
+        mesh->faceRecords.push_back(record);
+        return;
+    }
 
 
     float u0 = spriteX * textureSize;
@@ -238,20 +508,22 @@ void Chunk::addFace(const glm::vec3& pos, Face face) {
     glm::vec2 bottomLeft = glm::vec2(spriteX * textureSize, spriteY * textureSize);
     glm::vec2 topRight = glm::vec2((spriteX + 1) * textureSize, (spriteY + 1) * textureSize);
 
-    // Explicitly set vertices and texture coordinates for each face
+    // Explicitly set vertices and texture coordinates for each face. The
+    // corners go counter-clockwise seen from outside the box, so back faces
+    // can be culled.
     float voxelVerts[12];
     switch (face) {
         case Face::top:
             // Set UV and vertex positions for the top face
             texCoords[0] = glm::vec2(u0, v1); // 0
-            texCoords[1] = glm::vec2(u1, v1); // 1
+            texCoords[1] = glm::vec2(u0, v0); // 1
             texCoords[2] = glm::vec2(u1, v0); // 2
-            texCoords[3] = glm::vec2(u0, v0); // 3
+            texCoords[3] = glm::vec2(u1, v1); // 3
 
-            voxelVerts[0] = pos.x - 0.5f; voxelVerts[1] = pos.y + 0.5f; voxelVerts[2] = pos.z - 0.5f;
-            voxelVerts[3] = pos.x + 0.5f; voxelVerts[4] = pos.y + 0.5f; voxelVerts[5] = pos.z - 0.5f;
-            voxelVerts[6] = pos.x + 0.5f; voxelVerts[7] = pos.y + 0.5f; voxelVerts[8] = pos.z + 0.5f;
-            voxelVerts[9] = pos.x - 0.5f; voxelVerts[10] = pos.y + 0.5f; voxelVerts[11] = pos.z + 0.5f;
+            voxelVerts[0] = lo.x; voxelVerts[1] = hi.y; voxelVerts[2] = lo.z;
+            voxelVerts[3] = lo.x; voxelVerts[4] = hi.y; voxelVerts[5] = hi.z;
+            voxelVerts[6] = hi.x; voxelVerts[7] = hi.y; voxelVerts[8] = hi.z;
+            voxelVerts[9] = hi.x; voxelVerts[10] = hi.y; voxelVerts[11] = lo.z;
             break;
 
         case Face::bottom:
@@ -261,10 +533,10 @@ void Chunk::addFace(const glm::vec3& pos, Face face) {
             texCoords[2] = glm::vec2(u1, v0); // 2
             texCoords[3] = glm::vec2(u0, v0); // 3
 
-            voxelVerts[0] = pos.x - 0.5f; voxelVerts[1] = pos.y - 0.5f; voxelVerts[2] = pos.z - 0.5f;
-            voxelVerts[3] = pos.x + 0.5f; voxelVerts[4] = pos.y - 0.5f; voxelVerts[5] = pos.z - 0.5f;
-            voxelVerts[6] = pos.x + 0.5f; voxelVerts[7] = pos.y - 0.5f; voxelVerts[8] = pos.z + 0.5f;
-            voxelVerts[9] = pos.x - 0.5f; voxelVerts[10] = pos.y - 0.5f; voxelVerts[11] = pos.z + 0.5f;
+            voxelVerts[0] = lo.x; voxelVerts[1] = lo.y; voxelVerts[2] = lo.z;
+            voxelVerts[3] = hi.x; voxelVerts[4] = lo.y; voxelVerts[5] = lo.z;
+            voxelVerts[6] = hi.x; voxelVerts[7] = lo.y; voxelVerts[8] = hi.z;
+            voxelVerts[9] = lo.x; voxelVerts[10] = lo.y; voxelVerts[11] = hi.z;
             break;
 
         case Face::right:
@@ -274,23 +546,23 @@ void Chunk::addFace(const glm::vec3& pos, Face face) {
             texCoords[2] = glm::vec2(u0, v0); // 2
             texCoords[3] = glm::vec2(u0, v1); // 3
 
-            voxelVerts[0] = pos.x + 0.5f; voxelVerts[1] = pos.y - 0.5f; voxelVerts[2] = pos.z - 0.5f;
-            voxelVerts[3] = pos.x + 0.5f; voxelVerts[4] = pos.y + 0.5f; voxelVerts[5] = pos.z - 0.5f;
-            voxelVerts[6] = pos.x + 0.5f; voxelVerts[7] = pos.y + 0.5f; voxelVerts[8] = pos.z + 0.5f;
-            voxelVerts[9] = pos.x + 0.5f; voxelVerts[10] = pos.y - 0.5f; voxelVerts[11] = pos.z + 0.5f;
+            voxelVerts[0] = hi.x; voxelVerts[1] = lo.y; voxelVerts[2] = lo.z;
+            voxelVerts[3] = hi.x; voxelVerts[4] = hi.y; voxelVerts[5] = lo.z;
+            voxelVerts[6] = hi.x; voxelVerts[7] = hi.y; voxelVerts[8] = hi.z;
+            voxelVerts[9] = hi.x; voxelVerts[10] = lo.y; voxelVerts[11] = hi.z;
             break;
 
         case Face::left:
             // Set UV and vertex positions for the left face
             texCoords[0] = glm::vec2(u0, v1); // 0
-            texCoords[1] = glm::vec2(u0, v0); // 1
+            texCoords[1] = glm::vec2(u1, v1); // 1
             texCoords[2] = glm::vec2(u1, v0); // 2
-            texCoords[3] = glm::vec2(u1, v1); // 3
+            texCoords[3] = glm::vec2(u0, v0); // 3
 
-            voxelVerts[0] = pos.x - 0.5f; voxelVerts[1] = pos.y - 0.5f; voxelVerts[2] = pos.z - 0.5f;
-            voxelVerts[3] = pos.x - 0.5f; voxelVerts[4] = pos.y + 0.5f; voxelVerts[5] = pos.z - 0.5f;
-            voxelVerts[6] = pos.x - 0.5f; voxelVerts[7] = pos.y + 0.5f; voxelVerts[8] = pos.z + 0.5f;
-            voxelVerts[9] = pos.x - 0.5f; voxelVerts[10] = pos.y - 0.5f; voxelVerts[11] = pos.z + 0.5f;
+            voxelVerts[0] = lo.x; voxelVerts[1] = lo.y; voxelVerts[2] = lo.z;
+            voxelVerts[3] = lo.x; voxelVerts[4] = lo.y; voxelVerts[5] = hi.z;
+            voxelVerts[6] = lo.x; voxelVerts[7] = hi.y; voxelVerts[8] = hi.z;
+            voxelVerts[9] = lo.x; voxelVerts[10] = hi.y; voxelVerts[11] = lo.z;
             break;
 
         case Face::front:
@@ -300,39 +572,33 @@ void Chunk::addFace(const glm::vec3& pos, Face face) {
             texCoords[2] = glm::vec2(u0, v0); // 2
             texCoords[3] = glm::vec2(u1, v0); // 3
 
-            voxelVerts[0] = pos.x - 0.5f; voxelVerts[1] = pos.y - 0.5f; voxelVerts[2] = pos.z + 0.5f;
-            voxelVerts[3] = pos.x + 0.5f; voxelVerts[4] = pos.y - 0.5f; voxelVerts[5] = pos.z + 0.5f;
-            voxelVerts[6] = pos.x + 0.5f; voxelVerts[7] = pos.y + 0.5f; voxelVerts[8] = pos.z + 0.5f;
-            voxelVerts[9] = pos.x - 0.5f; voxelVerts[10] = pos.y + 0.5f; voxelVerts[11] = pos.z + 0.5f;
+            voxelVerts[0] = lo.x; voxelVerts[1] = lo.y; voxelVerts[2] = hi.z;
+            voxelVerts[3] = hi.x; voxelVerts[4] = lo.y; voxelVerts[5] = hi.z;
+            voxelVerts[6] = hi.x; voxelVerts[7] = hi.y; voxelVerts[8] = hi.z;
+            voxelVerts[9] = lo.x; voxelVerts[10] = hi.y; voxelVerts[11] = hi.z;
             break;
 
         case Face::back:
             // Set UV and vertex positions for the back face
             texCoords[0] = glm::vec2(u0, v1); // 0
-            texCoords[1] = glm::vec2(u1, v1); // 1
+            texCoords[1] = glm::vec2(u0, v0); // 1
             texCoords[2] = glm::vec2(u1, v0); // 2
-            texCoords[3] = glm::vec2(u0, v0); // 3
+            texCoords[3] = glm::vec2(u1, v1); // 3
 
-            voxelVerts[0] = pos.x - 0.5f; voxelVerts[1] = pos.y - 0.5f; voxelVerts[2] = pos.z - 0.5f;
-            voxelVerts[3] = pos.x + 0.5f; voxelVerts[4] = pos.y - 0.5f; voxelVerts[5] = pos.z - 0.5f;
-            voxelVerts[6] = pos.x + 0.5f; voxelVerts[7] = pos.y + 0.5f; voxelVerts[8] = pos.z - 0.5f;
-            voxelVerts[9] = pos.x - 0.5f; voxelVerts[10] = pos.y + 0.5f; voxelVerts[11] = pos.z - 0.5f;
+            voxelVerts[0] = lo.x; voxelVerts[1] = lo.y; voxelVerts[2] = lo.z;
+            voxelVerts[3] = lo.x; voxelVerts[4] = hi.y; voxelVerts[5] = lo.z;
+            voxelVerts[6] = hi.x; voxelVerts[7] = hi.y; voxelVerts[8] = lo.z;
+            voxelVerts[9] = hi.x; voxelVerts[10] = lo.y; voxelVerts[11] = lo.z;
             break;
     }
 
     // Store vertices and texture coordinates for the face
-    vertices.insert(vertices.end(), std::begin(voxelVerts), std::end(voxelVerts));
+    mesh->vertices.insert(mesh->vertices.end(), std::begin(voxelVerts), std::end(voxelVerts));
     for (int i = 0; i < 4; i++) {
-        texCoordsArray.push_back(texCoords[i].x);  // Add u component
-        texCoordsArray.push_back(texCoords[i].y);  // Add v component
-    }
-
-    // Define the face indices
-    unsigned int voxelIndices[6] = {0, 1, 2, 2, 3, 0};
-    unsigned int offset = (vertices.size() / 3) - 4;
-    for (auto index : voxelIndices) {
-        indices.push_back(index + offset);
+        mesh->texCoordsArray.push_back(texCoords[i].x);  // Add u component
+        mesh->texCoordsArray.push_back(texCoords[i].y);  // Add v component
     }
+    // No indices, every quad is drawn with the arena's shared {0,1,2,2,3,0} pattern
 }
 
 
@@ -382,7 +648,7 @@ void Chunk::bindTextures() {
 
 void Chunk::highlightVoxel(const glm::ivec3& voxel) {
     // Ensure the voxel is within the chunk bounds
-    cout << "Highlighting voxel" << voxel.x << voxel.y << voxel.z << endl; 
+    LOG_DEBUG("Highlighting voxel ", voxel.x, " ", voxel.y, " ", voxel.z);
     if (voxel.x >= 0 && voxel.x < sizeX && voxel.y >= 0 && voxel.y < sizeY && voxel.z >= 0 && voxel.z < sizeZ) {
         int faceStartIndex = voxel.x + voxel.y * sizeX + voxel.z * sizeX * sizeY;
         
@@ -392,7 +658,7 @@ void Chunk::highlightVoxel(const glm::ivec3& voxel) {
             colors[faceStartIndex * 18 + i * 3 + 1] = 1.0f;  // G
             colors[faceStartIndex * 18 + i * 3 + 2] = 1.0f;  // B
         }
-        cout << "done highlighting" << endl;
+        LOG_DEBUG("done highlighting");
 
         
     }
@@ -403,8 +669,13 @@ void Chunk::highlightVoxel(const glm::ivec3& voxel) {
 
 bool Chunk::isVoxelSolid(int x, int y, int z) {
     if (x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ) {
-        //print the voxel type
-        
+        if (voxels.empty()) {
+            // Coarse chunk, answer from the cell the voxel was merged into
+            int step = 1 << lodLevel;
+            int ny = std::max(1, sizeY / step), nz = std::max(1, sizeZ / step);
+            int cx = std::min(x / step, std::max(1, sizeX / step) - 1), cy = std::min(y / step, ny - 1), cz = std::min(z / step, nz - 1);
+            return lodCells[(cx * ny + cy) * nz + cz] != BlockType::Air;
+        }
         return voxels[x][y][z] != BlockType::Air;
     }
 
@@ -458,102 +729,169 @@ Chunk* Chunk::getLeftNeighbor() {
     int neighborChunkX = position.x - 1;
     int neighborChunkZ = position.z;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos); // Access the chunk map from the game
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second; // Return the chunk pointer if found
-    }
-    return nullptr; // Return nullptr if the neighbor isn't loaded
+    return gameRef->findLoadedChunk(neighborPos); // nullptr if the neighbor isn't loaded
 }
 
 Chunk* Chunk::getRightNeighbor() {
     int neighborChunkX = position.x + 1;
     int neighborChunkZ = position.z;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos);
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second;
-    }
-    return nullptr;
+    return gameRef->findLoadedChunk(neighborPos);
 }
 
 Chunk* Chunk::getFrontNeighbor() {
     int neighborChunkX = position.x;
     int neighborChunkZ = position.z + 1;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos);
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second;
-    }
-    return nullptr;
+    return gameRef->findLoadedChunk(neighborPos);
 }
 
 Chunk* Chunk::getBackNeighbor() {
     int neighborChunkX = position.x;
     int neighborChunkZ = position.z - 1;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos);
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second;
-    }
-    return nullptr;
+    return gameRef->findLoadedChunk(neighborPos);
 }
 
 Chunk* Chunk::getTopNeighbor() {
     int neighborChunkX = position.x;
     int neighborChunkZ = position.z;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos);
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second;
-    }
-    return nullptr;
+    return gameRef->findLoadedChunk(neighborPos);
 }
 
 Chunk* Chunk::getBottomNeighbor() {
     int neighborChunkX = position.x;
     int neighborChunkZ = position.z;
     std::pair<int, int> neighborPos = {neighborChunkX, neighborChunkZ};
-    auto it = gameRef->loadedChunks.find(neighborPos);
-
-    if (it != gameRef->loadedChunks.end()) {
-        return it->second;
+    return gameRef->findLoadedChunk(neighborPos);
+}
+bool Chunk::stageMesh(StagingRing& ring) {
+    PROFILE_ZONE("Chunk::stageMesh");
+    releaseStagedMesh();
+    if (mesh == nullptr) {
+        return false;
     }
-    return nullptr;
+    MeshData::trackScratchGrowth();
+    trackWorkerScratchGrowth();
+    meshVertexFloats = mesh->vertices.size();
+    meshTexCoordFloats = mesh->texCoordsArray.size();
+    meshFaceCount = mesh->faceRecords.size();
+    std::copy(std::begin(mesh->directionQuads), std::end(mesh->directionQuads), meshDirectionQuads);
+    if (!ring.reserve(mesh->byteSize(), stagedMesh)) {
+        // Keep a copy, the scratch buffers belong to this worker
+        if (mesh != &ownedMesh) {
+            ownedMesh.assign(*mesh);
+            mesh = &ownedMesh;
+        }
+        return false;
+    }
+    stagingRing = &ring;
+
+    // Layout inside the region: positions, texture coordinates, face records
+    char* dst = static_cast<char*>(ring.data(stagedMesh));
+    size_t vertexBytes = meshVertexFloats * sizeof(float);
+    size_t texCoordBytes = meshTexCoordFloats * sizeof(float);
+    memcpy(dst, mesh->vertices.data(), vertexBytes);
+    memcpy(dst + vertexBytes, mesh->texCoordsArray.data(), texCoordBytes);
+    memcpy(dst + vertexBytes + texCoordBytes, mesh->faceRecords.data(), meshFaceCount * sizeof(FaceRecord));
+    mesh = nullptr;
+    return true;
 }
-void Chunk::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glGenBuffers(1, &TBO);  // Texture buffer (No need for CBO anymore)
 
-    glBindVertexArray(VAO);
+void Chunk::releaseStagedMesh() {
+    if (stagingRing != nullptr && stagedMesh.valid()) {
+        stagingRing->release(stagedMesh);
+    }
+    stagedMesh = StagingRing::Region();
+    stagingRing = nullptr;
+}
 
-    // Bind vertex buffer (positions)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+void Chunk::releaseMesh() {
+    if (meshHandle != 0) {
+        if (meshFormat == MeshFormat::FaceRecords) {
+            gameRef->faceArena.free(meshHandle);
+        } else {
+            gameRef->meshArena.free(meshHandle);
+        }
+        meshHandle = 0;
+    }
+}
 
-    // Bind texture coordinate buffer
-    glBindBuffer(GL_ARRAY_BUFFER, TBO);
-    glBufferData(GL_ARRAY_BUFFER, texCoordsArray.size() * sizeof(float), texCoordsArray.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);  // 2 components for texture coordinates
-    glEnableVertexAttribArray(2);
+void Chunk::setupMesh() {
+    PROFILE_ZONE("Chunk::setupMesh");
+    // A staged mesh is already sitting in GPU-visible memory, let the GPU
+    // copy it into the arena
+    bool staged = stagingRing != nullptr && stagedMesh.valid();
+    if (!staged && mesh != nullptr) {
+        meshVertexFloats = mesh->vertices.size();
+        meshTexCoordFloats = mesh->texCoordsArray.size();
+        meshFaceCount = mesh->faceRecords.size();
+        std::copy(std::begin(mesh->directionQuads), std::end(mesh->directionQuads), meshDirectionQuads);
+    } else if (!staged) {
+        meshVertexFloats = meshTexCoordFloats = meshFaceCount = 0;
+        std::fill(std::begin(meshDirectionQuads), std::end(meshDirectionQuads), 0u);
+    }
+    size_t vertexBytes = meshVertexFloats * sizeof(float);
+    size_t texCoordBytes = meshTexCoordFloats * sizeof(float);
+
+    if (meshFormat == MeshFormat::FaceRecords) {
+        // Only records in this format, they sit after the (empty) vertex streams
+        FaceArena& faces = gameRef->faceArena;
+        size_t recordBytes = meshFaceCount * sizeof(FaceRecord);
+        meshHandle = faces.reallocate(meshHandle, static_cast<uint32_t>(meshFaceCount), position);
+        if (staged) {
+            faces.copyFromStaging(meshHandle, *stagingRing, stagedMesh, vertexBytes + texCoordBytes, recordBytes);
+            stagingRing->retire(stagedMesh);
+            stagedMesh = StagingRing::Region();
+            stagingRing = nullptr;
+        } else if (mesh != nullptr) {
+            faces.write(meshHandle, mesh->faceRecords.data(), recordBytes);
+        }
+        mesh = nullptr;
+        return;
+    }
 
-    
-    // Bind element buffer (indices)
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    // A remesh (block edits) reuses the chunk's arena space when it still fits
+    ChunkMeshArena& arena = gameRef->meshArena;
+    meshHandle = arena.reallocate(meshHandle, static_cast<uint32_t>(meshVertexFloats / 3), position);
+
+    if (staged) {
+        arena.copyFromStaging(meshHandle, ChunkMeshArena::Stream::Positions, *stagingRing, stagedMesh, 0, vertexBytes);
+        arena.copyFromStaging(meshHandle, ChunkMeshArena::Stream::TexCoords, *stagingRing, stagedMesh, vertexBytes, texCoordBytes);
+        stagingRing->retire(stagedMesh);
+        stagedMesh = StagingRing::Region();
+        stagingRing = nullptr;
+    } else if (mesh != nullptr) {
+        arena.write(meshHandle, ChunkMeshArena::Stream::Positions, mesh->vertices.data(), vertexBytes);
+        arena.write(meshHandle, ChunkMeshArena::Stream::TexCoords, mesh->texCoordsArray.data(), texCoordBytes);
+    }
+    mesh = nullptr;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+size_t Chunk::meshByteSize() const {
+    if (stagedMesh.valid()) {
+        return stagedMesh.size;
+    }
+    return mesh != nullptr ? mesh->byteSize() : 0;
 }
 
+ChunkMemory Chunk::memoryUsage() const {
+    ChunkMemory usage;
+    // The rows are sized once when allocated, so no need to visit all of them
+    usage.voxels = lodCells.capacity() * sizeof(BlockType);
+    if (!voxels.empty()) {
+        usage.voxels += voxels.capacity() * sizeof(voxels[0])
+                      + static_cast<size_t>(sizeX) * sizeY * (sizeof(std::vector<BlockType>) + sizeZ * sizeof(BlockType));
+    }
+    usage.cpuMesh = ownedMesh.capacityBytes();
+    usage.other = sizeof(Chunk) + colors.capacity() * sizeof(float) + tintFlagsArray.capacity() * sizeof(int)
+                + faceTextures.capacity() * sizeof(std::string) + occluderBoxes.capacity() * sizeof(glm::vec3);
+    if (meshHandle != 0) {
+        usage.gpuMesh = (meshVertexFloats + meshTexCoordFloats) * sizeof(float) + meshFaceCount * sizeof(FaceRecord);
+    }
+    return usage;
+}
 
 void Chunk::randomlyRemoveVoxels(){
     int x = rand() % sizeX;
@@ -564,7 +902,7 @@ void Chunk::randomlyRemoveVoxels(){
         if (voxels[x][y][z] != BlockType::Air) {
             // Remove this voxel
             voxels[x][y][z] = BlockType::Air;
-            std::cout << "Removing voxel at " << x << ", " << y << ", " << z << std::endl;
+            LOG_DEBUG("Removing voxel at ", x, ", ", y, ", ", z);
 
             // Regenerate chunk to reflect the change
             generateChunk();
@@ -576,48 +914,51 @@ void Chunk::randomlyRemoveVoxels(){
 
 
 
-void Chunk::render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection) {
-    glUseProgram(shaderProgram);
-    CHECK_GL_ERROR();
-
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
-
-    // Set the uniform matrices (model, view, projection)
-    int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    CHECK_GL_ERROR();
-
-    int viewLoc = glGetUniformLocation(shaderProgram, "view");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    CHECK_GL_ERROR();
-
-    int projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-    CHECK_GL_ERROR();
-
-    glBindVertexArray(VAO);
-    CHECK_GL_ERROR();
-
-    // Bind the entire texture atlas
-    GLuint textureID = textureManager.loadTexture("pics/mcspritesheet.png");
-    if (textureID == 0) {
-        std::cerr << "Error: Failed to load texture atlas" << std::endl;
+size_t Chunk::submit(RenderQueue& queue, GLuint atlasTexture, const glm::vec3& cameraPos) {
+    // A direction's faces can only face the camera when the camera is on
+    // their outer side of at least one of them; faces lie within the bounds,
+    // so a camera past the far side of the bounds sees them all from behind
+    glm::vec3 low = boundsMin(), high = boundsMax();
+    bool facing[6];
+    facing[Face::front] = cameraPos.z > low.z;
+    facing[Face::back] = cameraPos.z < high.z;
+    facing[Face::left] = cameraPos.x < high.x;
+    facing[Face::right] = cameraPos.x > low.x;
+    facing[Face::top] = cameraPos.y > low.y;
+    facing[Face::bottom] = cameraPos.y < high.y;
+
+    // Directions sit next to each other in the mesh, so neighbouring ones
+    // that are both facing go out as one draw
+    size_t triangles = 0;
+    uint32_t quad = 0;
+    int faceIndex = 0;
+    while (faceIndex < 6) {
+        if (!facing[faceIndex]) {
+            quad += meshDirectionQuads[faceIndex++];
+            continue;
+        }
+        uint32_t runStart = quad;
+        while (faceIndex < 6 && facing[faceIndex]) {
+            quad += meshDirectionQuads[faceIndex++];
+        }
+        if (quad > runStart) {
+            submitQuads(queue, atlasTexture, runStart, quad - runStart);
+            triangles += (quad - runStart) * 2;
+        }
     }
-    
-    glActiveTexture(GL_TEXTURE0);
-    
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    CHECK_GL_ERROR();  // Check if there's an OpenGL error after binding the texture.
-    glUniform1i(glGetUniformLocation(shaderProgram, "blockTexture"), 0);  // Set the atlas to the shader
-    CHECK_GL_ERROR();
-
-    // Draw all elements at once using the already set UV coordinates
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    CHECK_GL_ERROR();
+    return triangles;
+}
 
-    glBindVertexArray(0);
-    CHECK_GL_ERROR();
+void Chunk::submitQuads(RenderQueue& queue, GLuint atlasTexture, uint32_t firstQuad, uint32_t quadCount) {
+    if (meshFormat == MeshFormat::FaceRecords) {
+        FaceArena::DrawRange range = gameRef->faceArena.drawRange(meshHandle, firstQuad, quadCount);
+        queue.submit({shaderProgram, atlasTexture, range.vertexCount, static_cast<GLuint>(range.firstVertex), 0});
+        return;
+    }
+    // The shared 16 bit quad indices only reach QUADS_PER_DRAW quads at a time
+    ChunkMeshArena& arena = gameRef->meshArena;
+    for (uint32_t quad = firstQuad; quad < firstQuad + quadCount; quad += ChunkMeshArena::QUADS_PER_DRAW) {
+        ChunkMeshArena::DrawRange range = arena.drawRange(meshHandle, quad, firstQuad + quadCount - quad);
+        queue.submit({shaderProgram, atlasTexture, range.indexCount, range.firstIndex, range.baseVertex});
+    }
 }
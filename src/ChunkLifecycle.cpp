@@ -0,0 +1,153 @@
+#include "ChunkLifecycle.hpp"
+#include "Log.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    LatencyHistogram stages[ChunkTrace::STAGES];   // Requested is unused
+    LatencyHistogram requestToUpload;
+    size_t discarded = 0, neverDrawn = 0;
+    double slowMillis = ChunkLifecycle::DEFAULT_SLOW_MILLIS;
+    // Ring of the last MAX_SLOW_TRACES, allocated up front so recording one
+    // never allocates while chunks stream; slowCount keeps counting past it
+    ChunkTrace slowTraces[ChunkLifecycle::MAX_SLOW_TRACES];
+    size_t slowCount = 0;
+
+    void record(const ChunkTrace& trace, ChunkStage stage) {
+        if (trace.reached(stage) && trace.reached(static_cast<ChunkStage>(static_cast<int>(stage) - 1))) {
+            stages[static_cast<int>(stage)].record(static_cast<uint64_t>(trace.stageSeconds(stage) * 1e9));
+        }
+    }
+
+    double millis(const ChunkTrace& trace, ChunkStage stage) {
+        return trace.stageSeconds(stage) * 1000.0;
+    }
+}
+
+double ChunkTrace::stageSeconds(ChunkStage stage) const {
+    int index = static_cast<int>(stage);
+    if (index == 0 || at[index] <= 0.0 || at[index - 1] <= 0.0) {
+        return 0.0;
+    }
+    return at[index] - at[index - 1];
+}
+
+const char* ChunkLifecycle::name(ChunkStage stage) {
+    switch (stage) {
+        case ChunkStage::Requested:  return "requested";
+        case ChunkStage::Started:    return "started";
+        case ChunkStage::Generated:  return "generated";
+        case ChunkStage::Meshed:     return "meshed";
+        case ChunkStage::Queued:     return "queued";
+        case ChunkStage::Uploaded:   return "uploaded";
+        case ChunkStage::FirstDrawn: return "first drawn";
+        case ChunkStage::Unloaded:   return "unloaded";
+        case ChunkStage::Count:      break;
+    }
+    return "?";
+}
+
+void ChunkLifecycle::setSlowThreshold(double millis) {
+    slowMillis = millis;
+}
+
+void ChunkLifecycle::uploaded(const ChunkTrace& trace) {
+    for (int stage = static_cast<int>(ChunkStage::Started); stage <= static_cast<int>(ChunkStage::Uploaded); stage++) {
+        record(trace, static_cast<ChunkStage>(stage));
+    }
+    if (!trace.reached(ChunkStage::Requested)) {
+        return;
+    }
+    double total = trace.at[static_cast<int>(ChunkStage::Uploaded)] - trace.at[static_cast<int>(ChunkStage::Requested)];
+    requestToUpload.record(static_cast<uint64_t>(total * 1e9));
+    if (slowMillis <= 0.0 || total * 1000.0 < slowMillis) {
+        return;
+    }
+
+    LOG_WARN("Slow chunk (", trace.x, ", ", trace.z, ") lod ", trace.lod, ": ", total * 1000.0, " ms = waiting ",
+             millis(trace, ChunkStage::Started), " + generate ", millis(trace, ChunkStage::Generated),
+             " + mesh ", millis(trace, ChunkStage::Meshed), " + stage ", millis(trace, ChunkStage::Queued),
+             " + upload queue ", millis(trace, ChunkStage::Uploaded));
+    slowTraces[slowCount % MAX_SLOW_TRACES] = trace;
+    slowCount++;
+}
+
+void ChunkLifecycle::drawn(const ChunkTrace& trace) {
+    record(trace, ChunkStage::FirstDrawn);
+}
+
+void ChunkLifecycle::unloaded(const ChunkTrace& trace) {
+    if (!trace.reached(ChunkStage::Uploaded)) {
+        discarded++;
+        return;
+    }
+    if (!trace.reached(ChunkStage::FirstDrawn)) {
+        neverDrawn++;
+        return;
+    }
+    record(trace, ChunkStage::Unloaded);
+}
+
+const LatencyHistogram& ChunkLifecycle::stageHistogram(ChunkStage stage) {
+    return stages[static_cast<int>(stage)];
+}
+
+void ChunkLifecycle::printSummary() {
+    printf("chunk stage (ms)             count      p50      p95      p99      max\n");
+    for (int stage = 1; stage < ChunkTrace::STAGES; stage++) {
+        const LatencyHistogram& histogram = stages[stage];
+        char label[64];
+        snprintf(label, sizeof(label), "%s -> %s", name(static_cast<ChunkStage>(stage - 1)), name(static_cast<ChunkStage>(stage)));
+        printf("  %-24s %8llu %8.2f %8.2f %8.2f %8.2f\n", label, static_cast<unsigned long long>(histogram.count()),
+               histogram.percentile(50.0) * 1e-6, histogram.percentile(95.0) * 1e-6,
+               histogram.percentile(99.0) * 1e-6, histogram.maxNanos() * 1e-6);
+    }
+    printf("  %-24s %8llu %8.2f %8.2f %8.2f %8.2f\n", "requested -> uploaded", static_cast<unsigned long long>(requestToUpload.count()),
+           requestToUpload.percentile(50.0) * 1e-6, requestToUpload.percentile(95.0) * 1e-6,
+           requestToUpload.percentile(99.0) * 1e-6, requestToUpload.maxNanos() * 1e-6);
+    printf("  discarded before upload %zu, unloaded without being drawn %zu, slow (> %.0f ms) %zu\n",
+           discarded, neverDrawn, slowMillis, slowCount);
+    fflush(stdout);
+}
+
+bool ChunkLifecycle::writeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "ChunkLifecycle: can't write " << path << std::endl;
+        return false;
+    }
+    out << "{\"slow_threshold_ms\":" << slowMillis << ",\"discarded\":" << discarded << ",\"never_drawn\":" << neverDrawn
+        << ",\"slow_count\":" << slowCount
+        << ",\n\"stages\":{";
+    for (int stage = 1; stage < ChunkTrace::STAGES; stage++) {
+        out << (stage > 1 ? ",\n" : "\n") << "\"" << name(static_cast<ChunkStage>(stage)) << "\":";
+        stages[stage].writeJson(out);
+    }
+    out << ",\n\"requested to uploaded\":";
+    requestToUpload.writeJson(out);
+    // Slow traces oldest first, seconds relative to the request
+    out << "},\n\"slow\":[";
+    size_t stored = slowCount;
+    if (stored > MAX_SLOW_TRACES) {
+        stored = MAX_SLOW_TRACES;
+    }
+    size_t oldest = slowCount - stored;
+    for (size_t i = 0; i < stored; i++) {
+        const ChunkTrace& trace = slowTraces[(oldest + i) % MAX_SLOW_TRACES];
+        out << (i > 0 ? ",\n" : "\n") << "{\"x\":" << trace.x << ",\"z\":" << trace.z << ",\"lod\":" << trace.lod
+            << ",\"remesh\":" << (trace.remesh ? "true" : "false") << ",\"requested_at\":" << trace.at[0];
+        for (int stage = 1; stage < ChunkTrace::STAGES; stage++) {
+            out << ",\"" << name(static_cast<ChunkStage>(stage)) << "\":";
+            if (trace.at[stage] > 0.0) {
+                out << trace.at[stage] - trace.at[0];
+            } else {
+                out << "null";
+            }
+        }
+        out << "}";
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,195 @@
+#include "ChunkMeshArena.hpp"
+#include <algorithm>
+
+static const size_t POSITION_BYTES = 3 * sizeof(float);
+static const size_t TEXCOORD_BYTES = 2 * sizeof(float);
+
+ChunkMeshArena::ChunkMeshArena() : PagedArena("ChunkMeshArena", ARENA_PAGE_VERTICES) {
+}
+
+ChunkMeshArena::~ChunkMeshArena() {
+}
+
+bool ChunkMeshArena::init(uint32_t pageCount, uint32_t maxQuadsPerMesh) {
+    createBuffers(pageCount, positionBuffer, texCoordBuffer, pageTableBuffer);
+    createQuadIndices(maxQuadsPerMesh);
+    resetPages(pageCount);
+    pageOffsets.assign(pageCount, glm::vec4(0.0f));
+
+    glGenVertexArrays(1, &arenaVAO);
+    bindVertexLayout();
+
+    glGenTextures(1, &pageTableTex);
+    glBindTexture(GL_TEXTURE_BUFFER, pageTableTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pageTableBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return true;
+}
+
+void ChunkMeshArena::shutdown() {
+    GLuint buffers[4] = {positionBuffer, texCoordBuffer, quadIndexBuffer, pageTableBuffer};
+    glDeleteBuffers(4, buffers);
+    glDeleteVertexArrays(1, &arenaVAO);
+    glDeleteTextures(1, &pageTableTex);
+    positionBuffer = texCoordBuffer = quadIndexBuffer = pageTableBuffer = 0;
+    quadIndexCount = 0;
+    arenaVAO = 0;
+    pageTableTex = 0;
+    clearAllocations();
+}
+
+void ChunkMeshArena::createBuffers(uint32_t pageCount, GLuint& positions, GLuint& texCoords, GLuint& pageTable) {
+    size_t vertices = static_cast<size_t>(pageCount) * ARENA_PAGE_VERTICES;
+    glGenBuffers(1, &positions);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, positions);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertices * POSITION_BYTES, nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &texCoords);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, texCoords);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertices * TEXCOORD_BYTES, nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &pageTable);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pageTable);
+    glBufferData(GL_COPY_WRITE_BUFFER, pageCount * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ChunkMeshArena::createQuadIndices(uint32_t quads) {
+    quadIndexCount = quads < QUADS_PER_DRAW ? quads : QUADS_PER_DRAW;
+    std::vector<uint16_t> indices(static_cast<size_t>(quadIndexCount) * 6);
+    for (uint32_t quad = 0; quad < quadIndexCount; quad++) {
+        uint16_t first = static_cast<uint16_t>(quad * 4);
+        uint16_t* dst = &indices[static_cast<size_t>(quad) * 6];
+        dst[0] = first;
+        dst[1] = first + 1;
+        dst[2] = first + 2;
+        dst[3] = first + 2;
+        dst[4] = first + 3;
+        dst[5] = first;
+    }
+    glGenBuffers(1, &quadIndexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, quadIndexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ChunkMeshArena::bindVertexLayout() {
+    glBindVertexArray(arenaVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, POSITION_BYTES, (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, texCoordBuffer);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, TEXCOORD_BYTES, (void*)0);
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ChunkMeshArena::writePageTable(const Allocation& allocation) {
+    for (uint32_t page = allocation.firstPage; page < allocation.firstPage + allocation.pageCount; page++) {
+        pageOffsets[page] = glm::vec4(allocation.offset, 0.0f);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pageTableBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.firstPage * sizeof(glm::vec4), allocation.pageCount * sizeof(glm::vec4), &pageOffsets[allocation.firstPage]);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+ChunkMeshArena::Stats ChunkMeshArena::stats() const {
+    Stats result = pageStats(ARENA_PAGE_VERTICES * (POSITION_BYTES + TEXCOORD_BYTES) + sizeof(glm::vec4));
+    result.bytesReserved += quadIndexCount * 6 * sizeof(uint16_t);
+    return result;
+}
+
+GLuint ChunkMeshArena::bufferFor(Stream stream) const {
+    switch (stream) {
+        case Stream::Positions: return positionBuffer;
+        default: return texCoordBuffer;
+    }
+}
+
+size_t ChunkMeshArena::byteOffset(const Allocation& allocation, Stream stream) const {
+    size_t firstVertex = static_cast<size_t>(allocation.firstPage) * ARENA_PAGE_VERTICES;
+    switch (stream) {
+        case Stream::Positions: return firstVertex * POSITION_BYTES;
+        default: return firstVertex * TEXCOORD_BYTES;
+    }
+}
+
+void ChunkMeshArena::write(Handle handle, Stream stream, const void* data, size_t bytes) {
+    if (handle == 0 || bytes == 0) {
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferFor(stream));
+    glBufferSubData(GL_COPY_WRITE_BUFFER, byteOffset(allocationFor(handle), stream), bytes, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ChunkMeshArena::copyFromStaging(Handle handle, Stream stream, StagingRing& ring, const StagingRing::Region& region, size_t srcOffset, size_t bytes) {
+    if (handle == 0 || bytes == 0) {
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferFor(stream));
+    ring.copyTo(region, srcOffset, GL_COPY_WRITE_BUFFER, byteOffset(allocationFor(handle), stream), bytes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+ChunkMeshArena::DrawRange ChunkMeshArena::drawRange(Handle handle, uint32_t firstQuad, uint32_t quadCount) const {
+    if (handle == 0) {
+        return {0, 0, 0};
+    }
+    // The base vertex moves to the first quad, which still finds the mesh's
+    // pages in the page table since gl_VertexID includes it
+    const Allocation& allocation = allocationFor(handle);
+    uint32_t meshQuads = allocation.itemCount / 4;
+    firstQuad = std::min(firstQuad, meshQuads);
+    uint32_t quads = std::min(quadCount, meshQuads - firstQuad);
+    if (quads > QUADS_PER_DRAW) {
+        quads = QUADS_PER_DRAW;
+    }
+    return {static_cast<GLsizei>(quads * 6), 0,
+            static_cast<GLint>(allocation.firstPage * ARENA_PAGE_VERTICES + firstQuad * 4)};
+}
+
+void ChunkMeshArena::movePages(uint32_t fromPage, uint32_t toPage, uint32_t pageCount) {
+    // Same buffer on both ends is fine, a free block never overlaps a live one
+    size_t vertices = static_cast<size_t>(pageCount) * ARENA_PAGE_VERTICES;
+    size_t oldVertex = static_cast<size_t>(fromPage) * ARENA_PAGE_VERTICES;
+    size_t newVertex = static_cast<size_t>(toPage) * ARENA_PAGE_VERTICES;
+    glBindBuffer(GL_COPY_READ_BUFFER, positionBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, positionBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldVertex * POSITION_BYTES, newVertex * POSITION_BYTES, vertices * POSITION_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, texCoordBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, texCoordBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldVertex * TEXCOORD_BYTES, newVertex * TEXCOORD_BYTES, vertices * TEXCOORD_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ChunkMeshArena::growBuffers(uint32_t pageCount) {
+    // One copy each, allocations keep their pages
+    GLuint newPositions, newTexCoords, newPageTable;
+    createBuffers(pageCount, newPositions, newTexCoords, newPageTable);
+    size_t oldVertices = static_cast<size_t>(pages.capacity()) * ARENA_PAGE_VERTICES;
+    glBindBuffer(GL_COPY_READ_BUFFER, positionBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newPositions);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldVertices * POSITION_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, texCoordBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newTexCoords);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldVertices * TEXCOORD_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    pageOffsets.resize(pageCount, glm::vec4(0.0f));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newPageTable);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, pageOffsets.size() * sizeof(glm::vec4), pageOffsets.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GLuint oldBuffers[3] = {positionBuffer, texCoordBuffer, pageTableBuffer};
+    glDeleteBuffers(3, oldBuffers);
+    positionBuffer = newPositions;
+    texCoordBuffer = newTexCoords;
+    pageTableBuffer = newPageTable;
+
+    bindVertexLayout();
+    glBindTexture(GL_TEXTURE_BUFFER, pageTableTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pageTableBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
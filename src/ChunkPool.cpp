@@ -0,0 +1,93 @@
+#include "ChunkPool.hpp"
+#include "Chunk.hpp"
+#include <algorithm>
+
+ChunkPool::ChunkPool(size_t maxPooled) : maxPooled(maxPooled) {
+    freeChunks.reserve(maxPooled);
+    coarseChunks.reserve(maxPooled);
+}
+
+ChunkPool::~ChunkPool() {
+}
+
+Chunk* ChunkPool::acquire(int sizeX, int sizeY, int sizeZ, glm::vec3 position, Game* gameRef, GLuint shaderProgram, TextureManager& textureManager, int lodLevel) {
+    Chunk* chunk = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Chunk*>& chunks = lodLevel == 0 ? freeChunks : coarseChunks;
+        if (!chunks.empty() && chunks.back()->sizeX == sizeX && chunks.back()->sizeY == sizeY && chunks.back()->sizeZ == sizeZ) {
+            chunk = chunks.back();
+            chunks.pop_back();
+        } else {
+            created++;
+        }
+    }
+
+    if (chunk == nullptr) {
+        return new Chunk(sizeX, sizeY, sizeZ, position, gameRef, shaderProgram, textureManager, lodLevel);
+    }
+    chunk->reset(position, lodLevel);
+    return chunk;
+}
+
+void ChunkPool::reserve(size_t fullCount, size_t coarseCount, int sizeX, int sizeY, int sizeZ, Game* gameRef, GLuint shaderProgram, TextureManager& textureManager) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxPooled = std::max(maxPooled, std::max(fullCount, coarseCount));
+    freeChunks.reserve(maxPooled);
+    coarseChunks.reserve(maxPooled);
+    while (freeChunks.size() < fullCount) {
+        freeChunks.push_back(new Chunk(sizeX, sizeY, sizeZ, gameRef, shaderProgram, textureManager, 0));
+        created++;
+    }
+    while (coarseChunks.size() < coarseCount) {
+        coarseChunks.push_back(new Chunk(sizeX, sizeY, sizeZ, gameRef, shaderProgram, textureManager, 1));
+        created++;
+    }
+}
+
+void ChunkPool::release(Chunk* chunk) {
+    if (chunk == nullptr) {
+        return;
+    }
+    chunk->releaseStagedMesh();
+    chunk->releaseMesh();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Chunk*>& chunks = chunk->voxels.empty() ? coarseChunks : freeChunks;
+        if (chunks.size() < maxPooled) {
+            chunks.push_back(chunk);
+            return;
+        }
+    }
+    delete chunk;
+}
+
+void ChunkPool::clear() {
+    std::vector<Chunk*> chunks;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.swap(freeChunks);
+        chunks.insert(chunks.end(), coarseChunks.begin(), coarseChunks.end());
+        coarseChunks.clear();
+    }
+    for (Chunk* chunk : chunks) {
+        delete chunk;
+    }
+}
+
+size_t ChunkPool::pooledCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return freeChunks.size() + coarseChunks.size();
+}
+
+size_t ChunkPool::pooledBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (const Chunk* chunk : freeChunks) {
+        bytes += chunk->memoryUsage().ram();
+    }
+    for (const Chunk* chunk : coarseChunks) {
+        bytes += chunk->memoryUsage().ram();
+    }
+    return bytes;
+}
@@ -0,0 +1,90 @@
+#include "ChunkVisibility.hpp"
+#include "Chunk.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Step for each Face (front, back, left, right, top, bottom); opposite faces
+// differ only in the lowest bit
+static const glm::ivec3 FACE_STEPS[6] = {{0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+
+static int oppositeFace(int face) {
+    return face ^ 1;
+}
+
+ChunkVisibility::ChunkVisibility(int chunkSize) : chunkSize(chunkSize) {
+}
+
+void ChunkVisibility::reserve(int radius) {
+    // Same extent as collect() below: the area plus a ring, two layers
+    size_t cells = static_cast<size_t>(2 * radius + 3) * (2 * radius + 3) * 2;
+    seen.reserve(cells);
+    queue.reserve(cells);
+}
+
+void ChunkVisibility::collect(const ChunkMap& loadedChunks, const glm::vec3& cameraPos, const Frustum& frustum,
+                              unsigned int frame, int radius, std::vector<Chunk*>& visible) {
+    PROFILE_ZONE("ChunkVisibility::collect");
+    // Voxels are centered on integer coordinates, so chunk cells start half a voxel early
+    glm::ivec3 start(static_cast<int>(std::floor((cameraPos.x + 0.5f) / chunkSize)),
+                     static_cast<int>(std::floor((cameraPos.y + 0.5f) / chunkSize)),
+                     static_cast<int>(std::floor((cameraPos.z + 0.5f) / chunkSize)));
+
+    // Cells the walk may use: the loaded area plus a ring, one layer of sky
+    // above the chunks, and up to the camera if it flies higher
+    glm::ivec3 low(start.x - radius - 1, std::min(0, start.y), start.z - radius - 1);
+    glm::ivec3 high(start.x + radius + 1, std::max(1, start.y), start.z + radius + 1);
+    glm::ivec3 extent = high - low + glm::ivec3(1);
+    seen.assign(static_cast<size_t>(extent.x) * extent.y * extent.z, 0);
+    auto cellIndex = [&](const glm::ivec3& cell) {
+        glm::ivec3 local = cell - low;
+        return (static_cast<size_t>(local.x) * extent.y + local.y) * extent.z + local.z;
+    };
+    // Chunks only exist in the y = 0 layer
+    auto chunkAt = [&](const glm::ivec3& cell) -> Chunk* {
+        if (cell.y != 0) {
+            return nullptr;
+        }
+        auto it = loadedChunks.find({cell.x, cell.z});
+        return it != loadedChunks.end() ? it->second : nullptr;
+    };
+
+    queue.clear();
+    queue.push_back({start, -1, 0});
+    seen[cellIndex(start)] = 1;
+    visited = 0;
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        Node node = queue[head];
+        visited++;
+        Chunk* chunk = chunkAt(node.cell);
+        if (chunk != nullptr) {
+            visible.push_back(chunk);
+        }
+
+        for (int face = 0; face < 6; face++) {
+            // Only ever move away from the camera
+            if (node.directions & (1 << oppositeFace(face))) {
+                continue;
+            }
+            // and only through air that links the face we came in by to this one
+            if (chunk != nullptr && node.entryFace >= 0 && !chunk->facesConnected(static_cast<Face>(node.entryFace), static_cast<Face>(face))) {
+                continue;
+            }
+            glm::ivec3 next = node.cell + FACE_STEPS[face];
+            if (glm::any(glm::lessThan(next, low)) || glm::any(glm::greaterThan(next, high)) || seen[cellIndex(next)]) {
+                continue;
+            }
+
+            Chunk* nextChunk = chunkAt(next);
+            bool inView = nextChunk != nullptr
+                ? nextChunk->visibleFrame == frame
+                : frustum.intersectsBox(glm::vec3(next * chunkSize) - glm::vec3(0.5f), glm::vec3((next + glm::ivec3(1)) * chunkSize) - glm::vec3(0.5f));
+            if (!inView) {
+                continue;
+            }
+            seen[cellIndex(next)] = 1;
+            queue.push_back({next, static_cast<int8_t>(oppositeFace(face)), static_cast<uint8_t>(node.directions | (1 << face))});
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#include "EpochManager.hpp"
+#include "Chunk.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    struct LocalSlot {
+        const EpochManager* owner = nullptr;
+        void* slot = nullptr;
+    };
+    thread_local LocalSlot localSlotCache;
+}
+
+EpochManager::EpochManager(size_t maxThreads) : globalEpoch(1), slots(maxThreads) {
+}
+
+EpochManager::~EpochManager() {
+}
+
+void EpochManager::setReclaimer(std::function<void(Chunk*)> reclaimer) {
+    this->reclaimer = std::move(reclaimer);
+}
+
+EpochManager::Slot& EpochManager::localSlot() {
+    if (localSlotCache.owner == this) {
+        return *static_cast<Slot*>(localSlotCache.slot);
+    }
+    // First guard on this thread: claim a free slot (slots are never released,
+    // threads in this engine live as long as the pool)
+    for (Slot& slot : slots) {
+        bool expected = false;
+        if (slot.claimed.compare_exchange_strong(expected, true)) {
+            localSlotCache.owner = this;
+            localSlotCache.slot = &slot;
+            return slot;
+        }
+    }
+    std::cerr << "EpochManager: out of thread slots" << std::endl;
+    std::abort();
+}
+
+void EpochManager::enter() {
+    Slot& slot = localSlot();
+    if (slot.depth++ > 0) {
+        return;
+    }
+    // Publish the epoch we observed; retry if it moved in between so the main
+    // thread can never miss us while comparing against a newer retire epoch
+    uint64_t epoch = globalEpoch.load();
+    while (true) {
+        slot.epoch.store(epoch);
+        uint64_t current = globalEpoch.load();
+        if (current == epoch) {
+            break;
+        }
+        epoch = current;
+    }
+}
+
+void EpochManager::exit() {
+    Slot& slot = localSlot();
+    if (--slot.depth == 0) {
+        slot.epoch.store(0, std::memory_order_release);
+    }
+}
+
+void EpochManager::reserve(size_t chunks) {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retired.reserve(chunks);
+    reclaimable.reserve(chunks);
+}
+
+void EpochManager::retire(Chunk* chunk) {
+    if (chunk == nullptr) {
+        return;
+    }
+    // Anyone entering after this increment can no longer find the chunk
+    uint64_t epoch = globalEpoch.fetch_add(1);
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    retired.push_back({chunk, epoch});
+}
+
+uint64_t EpochManager::oldestActiveEpoch() const {
+    uint64_t oldest = UINT64_MAX;
+    for (const Slot& slot : slots) {
+        if (!slot.claimed.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        uint64_t epoch = slot.epoch.load();
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+size_t EpochManager::reclaim(size_t maxChunks) {
+    std::vector<Chunk*>& toDelete = reclaimable;
+    toDelete.clear();
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        if (retired.empty()) {
+            return 0;
+        }
+        uint64_t oldest = oldestActiveEpoch();
+        // retired is ordered by epoch, so the safe entries form a prefix
+        size_t count = 0;
+        while (count < retired.size() && count < maxChunks && retired[count].epoch < oldest) {
+            toDelete.push_back(retired[count].chunk);
+            count++;
+        }
+        retired.erase(retired.begin(), retired.begin() + count);
+    }
+    for (Chunk* chunk : toDelete) {
+        if (reclaimer) {
+            reclaimer(chunk);
+        } else {
+            delete chunk;
+        }
+    }
+    return toDelete.size();
+}
+
+size_t EpochManager::reclaimAll() {
+    return reclaim(SIZE_MAX);
+}
+
+size_t EpochManager::pendingCount() const {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return retired.size();
+}
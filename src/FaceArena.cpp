@@ -0,0 +1,123 @@
+#include "FaceArena.hpp"
+#include <algorithm>
+
+static const size_t RECORD_BYTES = sizeof(FaceRecord);
+static const size_t PAGE_BYTES = FaceArena::FACE_PAGE_RECORDS * RECORD_BYTES;
+
+FaceArena::FaceArena() : PagedArena("FaceArena", FACE_PAGE_RECORDS) {
+}
+
+FaceArena::~FaceArena() {
+}
+
+bool FaceArena::init(uint32_t pageCount) {
+    createBuffers(pageCount, recordBuffer, pageTableBuffer);
+    resetPages(pageCount);
+    pageOffsets.assign(pageCount, glm::vec4(0.0f));
+
+    glGenVertexArrays(1, &emptyVAO);
+    glGenTextures(1, &recordTex);
+    glGenTextures(1, &pageTableTex);
+    attachTextures();
+    return true;
+}
+
+void FaceArena::shutdown() {
+    GLuint buffers[2] = {recordBuffer, pageTableBuffer};
+    glDeleteBuffers(2, buffers);
+    GLuint textures[2] = {recordTex, pageTableTex};
+    glDeleteTextures(2, textures);
+    glDeleteVertexArrays(1, &emptyVAO);
+    recordBuffer = pageTableBuffer = 0;
+    recordTex = pageTableTex = 0;
+    emptyVAO = 0;
+    clearAllocations();
+}
+
+void FaceArena::createBuffers(uint32_t pageCount, GLuint& records, GLuint& pageTable) {
+    glGenBuffers(1, &records);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, records);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<size_t>(pageCount) * PAGE_BYTES, nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &pageTable);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pageTable);
+    glBufferData(GL_COPY_WRITE_BUFFER, pageCount * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void FaceArena::attachTextures() {
+    glBindTexture(GL_TEXTURE_BUFFER, recordTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, recordBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, pageTableTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pageTableBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void FaceArena::writePageTable(const Allocation& allocation) {
+    for (uint32_t page = allocation.firstPage; page < allocation.firstPage + allocation.pageCount; page++) {
+        pageOffsets[page] = glm::vec4(allocation.offset, 0.0f);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pageTableBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.firstPage * sizeof(glm::vec4), allocation.pageCount * sizeof(glm::vec4), &pageOffsets[allocation.firstPage]);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+FaceArena::Stats FaceArena::stats() const {
+    return pageStats(PAGE_BYTES + sizeof(glm::vec4));
+}
+
+void FaceArena::write(Handle handle, const void* data, size_t bytes) {
+    if (handle == 0 || bytes == 0) {
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, recordBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocationFor(handle).firstPage * PAGE_BYTES, bytes, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void FaceArena::copyFromStaging(Handle handle, StagingRing& ring, const StagingRing::Region& region, size_t srcOffset, size_t bytes) {
+    if (handle == 0 || bytes == 0) {
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, recordBuffer);
+    ring.copyTo(region, srcOffset, GL_COPY_WRITE_BUFFER, allocationFor(handle).firstPage * PAGE_BYTES, bytes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+FaceArena::DrawRange FaceArena::drawRange(Handle handle, uint32_t firstFace, uint32_t faceCount) const {
+    if (handle == 0) {
+        return {0, 0};
+    }
+    const Allocation& allocation = allocationFor(handle);
+    firstFace = std::min(firstFace, allocation.itemCount);
+    uint32_t faces = std::min(faceCount, allocation.itemCount - firstFace);
+    return {static_cast<GLint>((allocation.firstPage * FACE_PAGE_RECORDS + firstFace) * VERTICES_PER_FACE),
+            static_cast<GLsizei>(faces * VERTICES_PER_FACE)};
+}
+
+void FaceArena::movePages(uint32_t fromPage, uint32_t toPage, uint32_t pageCount) {
+    glBindBuffer(GL_COPY_READ_BUFFER, recordBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, recordBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, fromPage * PAGE_BYTES, toPage * PAGE_BYTES, pageCount * PAGE_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void FaceArena::growBuffers(uint32_t pageCount) {
+    GLuint newRecords, newPageTable;
+    createBuffers(pageCount, newRecords, newPageTable);
+    glBindBuffer(GL_COPY_READ_BUFFER, recordBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newRecords);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, pages.capacity() * PAGE_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    pageOffsets.resize(pageCount, glm::vec4(0.0f));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newPageTable);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, pageOffsets.size() * sizeof(glm::vec4), pageOffsets.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GLuint oldBuffers[2] = {recordBuffer, pageTableBuffer};
+    glDeleteBuffers(2, oldBuffers);
+    recordBuffer = newRecords;
+    pageTableBuffer = newPageTable;
+    attachTextures();
+}
@@ -0,0 +1,179 @@
+#include "FrameStats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sys/resource.h>
+
+FrameStats::FrameStats(size_t windowSize) : frameMillis(windowSize, 0.0f) {
+    lastReport = nowSeconds();
+}
+
+double FrameStats::nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameStats::beginFrame() {
+    frameStart = nowSeconds();
+}
+
+void FrameStats::endFrame() {
+    frameMillis[next] = static_cast<float>((nowSeconds() - frameStart) * 1000.0);
+    next = (next + 1) % frameMillis.size();
+    count = std::min(count + 1, frameMillis.size());
+}
+
+void FrameStats::addUploads(size_t chunks, size_t bytes) {
+    uploadedChunks += chunks;
+    uploadedBytes += bytes;
+}
+
+void FrameStats::addCulling(size_t drawn, size_t culled) {
+    drawnChunks += drawn;
+    culledChunks += culled;
+    culledFrames++;
+}
+
+void FrameStats::addOcclusion(size_t occluded) {
+    occludedChunks += occluded;
+}
+
+void FrameStats::addCaveCulling(size_t unreachable) {
+    unreachableChunks += unreachable;
+}
+
+void FrameStats::addHorizon(size_t tiles, size_t triangles) {
+    horizonTiles += tiles;
+    horizonTriangles += triangles;
+}
+
+void FrameStats::addChunkTriangles(size_t submitted, size_t facingAway) {
+    submittedTriangles += submitted;
+    facingAwayTriangles += facingAway;
+}
+
+void FrameStats::addDrawCalls(size_t calls) {
+    drawCalls += calls;
+}
+
+void FrameStats::addLoadedChunks(size_t loaded) {
+    loadedChunks += loaded;
+}
+
+void FrameStats::addStreaming(size_t generated, size_t discarded) {
+    generatedChunks += generated;
+    discardedChunks += discarded;
+}
+
+void FrameStats::addChunkLoadLatency(float millis) {
+    loadLatencies.record(static_cast<uint64_t>(std::max(0.0f, millis) * 1e6f));
+}
+
+void FrameStats::setMeshMemory(size_t bytesInUse, size_t bytesReserved, float fragmentation) {
+    peakMeshBytes = std::max(peakMeshBytes, bytesReserved);
+    meshBytesInUse = bytesInUse;
+    meshBytesReserved = bytesReserved;
+    meshFragmentation = fragmentation;
+}
+
+float FrameStats::percentile(float p) const {
+    return percentile(std::vector<float>(frameMillis.begin(), frameMillis.begin() + count), p);
+}
+
+float FrameStats::percentile(std::vector<float> values, float p) {
+    if (values.empty()) {
+        return 0.0f;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p / 100.0f * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+size_t FrameStats::peakResidentBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);          // bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;   // kilobytes on Linux
+#endif
+}
+
+float FrameStats::maxFrameMillis() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    return *std::max_element(frameMillis.begin(), frameMillis.begin() + count);
+}
+
+void FrameStats::report(float intervalSeconds) {
+    double now = nowSeconds();
+    if (now - lastReport < intervalSeconds) {
+        return;
+    }
+    lastReport = now;
+    std::cout << "Frame ms p50 " << percentile(50.0f) << " p95 " << percentile(95.0f)
+              << " p99 " << percentile(99.0f) << " max " << maxFrameMillis()
+              << " | uploaded " << uploadedChunks << " chunks, " << uploadedBytes / 1024 << " KB"
+              << " | load ms p50 " << loadLatencies.percentile(50.0) * 1e-6 << " p95 " << loadLatencies.percentile(95.0) * 1e-6;
+    if (culledFrames > 0) {
+        std::cout << " | chunks/frame in frustum " << drawnChunks / culledFrames << " culled " << culledChunks / culledFrames
+                  << " unreachable " << unreachableChunks / culledFrames
+                  << " occluded " << occludedChunks / culledFrames
+                  << " | chunk triangles " << submittedTriangles / culledFrames
+                  << " skipped facing away " << facingAwayTriangles / culledFrames
+                  << " | horizon tiles " << horizonTiles / culledFrames << " triangles " << horizonTriangles / culledFrames
+                  << " | draw calls " << drawCalls / culledFrames;
+    }
+    if (meshBytesReserved > 0) {
+        std::cout << " | meshes " << meshBytesInUse / 1024 << "/" << meshBytesReserved / 1024
+                  << " KB, fragmentation " << meshFragmentation;
+    }
+    std::cout << std::endl;
+    uploadedChunks = 0;
+    uploadedBytes = 0;
+    drawnChunks = 0;
+    culledChunks = 0;
+    occludedChunks = 0;
+    unreachableChunks = 0;
+    horizonTiles = 0;
+    horizonTriangles = 0;
+    submittedTriangles = 0;
+    facingAwayTriangles = 0;
+    drawCalls = 0;
+    loadedChunks = 0;
+    generatedChunks = 0;
+    discardedChunks = 0;
+    loadLatencies.clear();
+    culledFrames = 0;
+}
+
+void FrameStats::summary() {
+    float meanMillis = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        meanMillis += frameMillis[i];
+    }
+    meanMillis = count > 0 ? meanMillis / count : 0.0f;
+    size_t frames = culledFrames > 0 ? culledFrames : 1;
+    std::cout << "frames " << count << std::endl
+              << "cpu frame ms mean " << meanMillis << " p50 " << percentile(50.0f) << " p95 " << percentile(95.0f)
+              << " p99 " << percentile(99.0f) << " max " << maxFrameMillis() << std::endl
+              << "draw calls/frame " << drawCalls / frames << std::endl
+              << "triangles/frame chunks " << submittedTriangles / frames << " (skipped facing away " << facingAwayTriangles / frames
+              << ") horizon " << horizonTriangles / frames << std::endl
+              << "chunks/frame loaded " << loadedChunks / frames << " in frustum " << drawnChunks / frames
+              << " culled " << culledChunks / frames << " unreachable " << unreachableChunks / frames
+              << " occluded " << occludedChunks / frames << std::endl
+              << "chunks generated " << generatedChunks << " discarded " << discardedChunks
+              << " uploaded " << uploadedChunks << ", " << uploadedBytes / 1024 << " KB" << std::endl
+              << "chunk load ms (queued to first draw) p50 " << loadLatencies.percentile(50.0) * 1e-6
+              << " p95 " << loadLatencies.percentile(95.0) * 1e-6 << " max " << loadLatencies.maxNanos() * 1e-6
+              << " over " << loadLatencies.count() << " chunks" << std::endl;
+    if (meshBytesReserved > 0) {
+        std::cout << "meshes " << meshBytesInUse / 1024 << "/" << meshBytesReserved / 1024
+                  << " KB, fragmentation " << meshFragmentation << std::endl;
+    }
+    std::cout << "peak memory: process " << peakResidentBytes() / (1024 * 1024) << " MB, meshes "
+              << peakMeshBytes / 1024 << " KB reserved" << std::endl;
+}
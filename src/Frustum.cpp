@@ -0,0 +1,72 @@
+#include "Frustum.hpp"
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    update(viewProjection);
+}
+
+void Frustum::update(const glm::mat4& viewProjection) {
+    // Gribb/Hartmann: rows of the clip matrix added to / subtracted from the w row
+    glm::mat4 m = glm::transpose(viewProjection);
+    planes[0] = m[3] + m[0];  // left
+    planes[1] = m[3] - m[0];  // right
+    planes[2] = m[3] + m[1];  // bottom
+    planes[3] = m[3] - m[1];  // top
+    planes[4] = m[3] + m[2];  // near
+    planes[5] = m[3] - m[2];  // far
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::intersectsBox(const glm::vec3& min, const glm::vec3& max) const {
+    for (const glm::vec4& plane : planes) {
+        // Corner furthest along the plane normal
+        glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x,
+                           plane.y >= 0.0f ? max.y : min.y,
+                           plane.z >= 0.0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BoxBatch::clear() {
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void BoxBatch::reserve(size_t count) {
+    minX.reserve(count); minY.reserve(count); minZ.reserve(count);
+    maxX.reserve(count); maxY.reserve(count); maxZ.reserve(count);
+}
+
+void BoxBatch::add(const glm::vec3& min, const glm::vec3& max) {
+    minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+    maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+}
+
+size_t BoxBatch::cull(const Frustum& frustum, std::vector<uint8_t>& visible) const {
+    size_t count = size();
+    visible.assign(count, 1);
+    uint8_t* out = visible.data();
+
+    // One plane at a time over all boxes. The plane's sign pattern picks which
+    // arrays hold the positive vertex, so the inner loop has no branches.
+    for (const glm::vec4& plane : frustum.planes) {
+        const float* px = plane.x >= 0.0f ? maxX.data() : minX.data();
+        const float* py = plane.y >= 0.0f ? maxY.data() : minY.data();
+        const float* pz = plane.z >= 0.0f ? maxZ.data() : minZ.data();
+        float a = plane.x, b = plane.y, c = plane.z, d = plane.w;
+        for (size_t i = 0; i < count; i++) {
+            float distance = a * px[i] + b * py[i] + c * pz[i] + d;
+            out[i] &= static_cast<uint8_t>(distance >= 0.0f);
+        }
+    }
+
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        visibleCount += out[i];
+    }
+    return visibleCount;
+}
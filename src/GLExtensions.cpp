@@ -0,0 +1,46 @@
+#include "GLExtensions.hpp"
+#include <iostream>
+
+int GLExtensions::majorVersion = 3;
+int GLExtensions::minorVersion = 3;
+bool GLExtensions::bufferStorage = false;
+PFNGLBUFFERSTORAGEPROC GLExtensions::glBufferStorage = nullptr;
+bool GLExtensions::multiDrawIndirect = false;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC GLExtensions::glMultiDrawElementsIndirect = nullptr;
+PFNGLMULTIDRAWARRAYSINDIRECTPROC GLExtensions::glMultiDrawArraysIndirect = nullptr;
+
+bool GLExtensions::atLeast(int major, int minor) {
+    return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+}
+
+bool GLExtensions::hasExtension(const std::string& name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && name == extension) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GLExtensions::load(GLADloadproc loader) {
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+    if (atLeast(4, 4) || hasExtension("GL_ARB_buffer_storage")) {
+        glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(loader("glBufferStorage"));
+    }
+    bufferStorage = glBufferStorage != nullptr;
+
+    if (atLeast(4, 3) || hasExtension("GL_ARB_multi_draw_indirect")) {
+        glMultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(loader("glMultiDrawElementsIndirect"));
+        glMultiDrawArraysIndirect = reinterpret_cast<PFNGLMULTIDRAWARRAYSINDIRECTPROC>(loader("glMultiDrawArraysIndirect"));
+    }
+    multiDrawIndirect = glMultiDrawElementsIndirect != nullptr && glMultiDrawArraysIndirect != nullptr;
+
+    std::cout << "OpenGL " << majorVersion << "." << minorVersion
+              << " buffer_storage: " << (bufferStorage ? "yes" : "no")
+              << " multi_draw_indirect: " << (multiDrawIndirect ? "yes" : "no") << std::endl;
+}
@@ -2,10 +2,32 @@
 #include "Cube.hpp"
 #include "Chunk.hpp"
 #include "Camera.hpp"
+#include "EpochManager.hpp"
+#include "UploadScheduler.hpp"
+#include "FrameStats.hpp"
+#include "GLExtensions.hpp"
+#include "StagingRing.hpp"
+#include "ChunkPool.hpp"
+#include "MPSCQueue.hpp"
+#include "Frustum.hpp"
+#include "RenderQueue.hpp"
+#include "OcclusionCuller.hpp"
+#include "ChunkVisibility.hpp"
+#include "ChunkLod.hpp"
+#include "HorizonRenderer.hpp"
+#include "TerrainNoise.hpp"
+#include "Profiler.hpp"
+#include "Log.hpp"
+#include "MemoryStats.hpp"
+#include "ChunkLifecycle.hpp"
+#include "AllocTracker.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <unordered_set>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
 using namespace std;
 
 #include <utility>      // For std::pair
@@ -23,6 +45,25 @@ namespace std {
 }
 
 #define CHUNK_SIZE 16
+#define MAX_CHUNKS_RECLAIMED_PER_FRAME 8
+#define STAGING_RING_BYTES (16 * 1024 * 1024)
+// Starting size of the shared chunk mesh buffers, they double when full
+#define MESH_ARENA_PAGES 512
+// Most faces a chunk can have (leaves show all 6 even next to each other), sizes the shared quad index buffer
+#define MAX_CHUNK_QUADS (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6)
+#define FACE_ARENA_PAGES 2048
+// Nearest visible chunks whose solid boxes are drawn as occluders each frame
+#define MAX_OCCLUDER_CHUNKS 24
+#define OCCLUSION_THREADS 4
+// The height field horizon reaches this many times the voxel render distance
+#define HORIZON_DISTANCE_SCALE 4
+#define SCRIPT_FRAME_SECONDS (1.0f / SCRIPT_FPS)
+// Camera path recording keeps one keyframe per this many seconds
+#define RECORD_INTERVAL_SECONDS 0.1f
+// F9 saves a Chrome trace of this many seconds of profiler zones
+#define TRACE_HOTKEY_SECONDS 10.0
+// Sampling walks every chunk, a few times a second is plenty for the peaks
+#define MEMORY_SAMPLE_FRAMES 30
 
 Chunk *chunk;
 Camera *camera;
@@ -36,8 +77,20 @@ ThreadPool threadPool(8);
 TextureManager *textureManager = new TextureManager();
 
 
-std::deque<Chunk*> chunksToAdd;
-std::mutex chunkMutex;
+// Meshed chunks handed from the workers to the GL thread
+MPSCQueue<Chunk*> chunksToAdd(1024);
+// Nodes recycled like loadedChunks'
+std::unordered_set<std::pair<int, int>, std::hash<std::pair<int, int>>, std::equal_to<std::pair<int, int>>,
+                   RecyclingAllocator<std::pair<int, int>>> chunksInQueue;
+EpochManager chunkEpochs;
+UploadScheduler uploadScheduler;
+FrameStats frameStats;
+StagingRing stagingRing;
+ChunkPool chunkPool;
+RenderQueue renderQueue;
+OcclusionCuller occlusionCuller(OCCLUSION_THREADS);
+ChunkVisibility chunkVisibility(CHUNK_SIZE);
+HorizonRenderer horizonRenderer;
 
 
 
@@ -79,13 +132,13 @@ void Game::mouse_click_callback(GLFWwindow* window, int button, int action, int
         glm::vec3 rayDirection = camera->cameraFront;    // The ray is cast in the direction the camera is facing
         glm::ivec3 hitVoxel;
 
-        cout << "Raycasting" << endl;
-        cout << "Ray Origin: " << rayOrigin.x << " " << rayOrigin.y << " " << rayOrigin.z << endl;
-        cout << "Ray Direction: " << rayDirection.x << " " << rayDirection.y << " " << rayDirection.z << endl;
+        LOG_DEBUG("Raycasting");
+        LOG_DEBUG("Ray Origin: ", rayOrigin.x, " ", rayOrigin.y, " ", rayOrigin.z);
+        LOG_DEBUG("Ray Direction: ", rayDirection.x, " ", rayDirection.y, " ", rayDirection.z);
         
         if (game->castRayForVoxel(rayOrigin, rayDirection, hitVoxel, 50.0f)) {
         // If a voxel was hit, highlight or mark it (implement the logic to highlight)
-            cout << "Voxel hit at " << hitVoxel.x << " " << hitVoxel.y << " " << hitVoxel.z << endl;
+            LOG_DEBUG("Voxel hit at ", hitVoxel.x, " ", hitVoxel.y, " ", hitVoxel.z);
             //find the chunk that the ray is in
     }
 
@@ -95,14 +148,26 @@ void Game::mouse_click_callback(GLFWwindow* window, int button, int action, int
 
 void Game::key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
 
-    std::cout << "Key callback: key=" << key << " action=" << action << std::endl;
+    LOG_TRACE("Key callback: key=", key, " action=", action);
     Game* game = (Game*)glfwGetWindowUserPointer(window);
     game->ProcessInput(0.0f);
 
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+        static int traceCount = 0;
+        Profiler::writeChromeTrace("trace-" + std::to_string(traceCount++) + ".json", TRACE_HOTKEY_SECONDS);
+    }
+    if (key == GLFW_KEY_F10 && action == GLFW_PRESS) {
+        game->SampleMemory();
+        MemoryStats::print();
+    }
+
 }
 
 
 bool Game::raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, Chunk& chunk, glm::ivec3& hitVoxel, float maxDistance) {
+    if (chunk.voxels.empty()) {
+        return false;   // a coarse chunk has no voxels to edit
+    }
     glm::vec3 rayPos = rayOrigin;  // Starting point of the ray
     glm::vec3 stepSize = glm::vec3(1.0f) / glm::abs(rayDirection);  // Step size for each axis
     glm::ivec3 currentVoxel = glm::ivec3(std::floor(rayPos.x), std::floor(rayPos.y), std::floor(rayPos.z));  // Starting voxel
@@ -119,7 +184,7 @@ bool Game::raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, Ch
 
     while (distance < maxDistance) {
         // Debug the current ray position
-        std::cout << "Raycasting at voxel: (" << currentVoxel.x << ", " << currentVoxel.y << ", " << currentVoxel.z << ")" << std::endl;
+        LOG_TRACE("Raycasting at voxel: (", currentVoxel.x, ", ", currentVoxel.y, ", ", currentVoxel.z, ")");
         
         
 
@@ -129,7 +194,7 @@ bool Game::raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, Ch
             chunk.voxels[currentVoxel.x][currentVoxel.y][currentVoxel.z] = BlockType::Air;  // Remove the voxel
             chunk.generateChunk();  // Regenerate the chunk
             chunk.setupMesh();  // Setup the mesh
-            cout << "we hit a solid voxel" << endl;
+            LOG_DEBUG("we hit a solid voxel");
             return true;  // Ray hit a solid voxel
         }
 
@@ -163,16 +228,21 @@ bool Game::raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, Ch
             break;
         }
     }
-    cout << "Raycast finished" << endl;
-    cout << "Ray hit nothing" << endl;
+    LOG_DEBUG("Raycast finished, ray hit nothing");
     return false;  // No voxel was hit
 }
 
-Game::Game(int width, int height) 
-    : width(width), height(height) {
+Game::Game(int width, int height, int renderDistance, MeshFormat meshFormat) 
+    : renderDistance(renderDistance), meshFormat(meshFormat), width(width), height(height),
+      chunkJobs(CHUNK_JOB_SLOTS), freeChunkJobs(CHUNK_JOB_SLOTS) {
+    for (uint32_t slot = 0; slot < CHUNK_JOB_SLOTS; slot++) {
+        freeChunkJobs.push(slot);
+    }
 }
 
 Game::~Game() {
+    // The pool outlives the game, its tasks must not run into the members below
+    threadPool.drain();
     for (auto& chunkPair : loadedChunks) {
         if (chunkPair.second != nullptr) { // Check if the chunk pointer is valid
             delete chunkPair.second; // Delete each chunk
@@ -180,48 +250,112 @@ Game::~Game() {
         }
     }
     loadedChunks.clear(); // Clear the map after deletion
-    glfwTerminate();       // Terminate GLFW
+    std::vector<Chunk*> pendingChunks;
+    uploadScheduler.discardIf([](const Chunk*) { return true; }, pendingChunks);
+    // and the ones the workers finished that we haven't collected yet
+    Chunk* readyChunk;
+    while (chunksToAdd.tryPop(readyChunk)) {
+        pendingChunks.push_back(readyChunk);
+    }
+    for (Chunk* pendingChunk : pendingChunks) {
+        chunkEpochs.retire(pendingChunk);
+    }
+    chunkEpochs.reclaimAll(); // Free retired chunks while the GL context is still alive
+    chunkPool.clear();
+    stagingRing.shutdown();
+    renderQueue.shutdown();
+    horizonRenderer.shutdown();
+    meshArena.shutdown();
+    faceArena.shutdown();
+    if (headless) {
+        headlessContext.destroy();
+    } else {
+        glfwTerminate();       // Terminate GLFW
+    }
 }
 
 void Game::Init() {
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW\n";
-        exit(-1);
-    }
+    if (headless) {
+        // Offscreen, nothing from GLFW is used
+        if (!headlessContext.create(width, height)) {
+            exit(-1);
+        }
+        GLExtensions::load((GLADloadproc)HeadlessContext::getProcAddress);
+    } else {
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW\n";
+            exit(-1);
+        }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    window = glfwCreateWindow(width, height, "OpenGL Game", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        exit(-1);
-    }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        window = glfwCreateWindow(width, height, "OpenGL Game", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window\n";
+            glfwTerminate();
+            exit(-1);
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return;
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return;
+        }
+        GLExtensions::load((GLADloadproc)glfwGetProcAddress);
     }
+    AllocTracker::hookGlObjectCalls();
+    stagingRing.init(STAGING_RING_BYTES);
+    Chunk::meshFormat = meshFormat;
+    if (meshFormat == MeshFormat::FaceRecords) {
+        faceArena.init(FACE_ARENA_PAGES);
+    } else {
+        meshArena.init(MESH_ARENA_PAGES, MAX_CHUNK_QUADS);
+    }
+    // Warm the streaming containers for a full view (twice, for the frames
+    // where the old edge isn't unloaded yet), so streaming stops allocating
+    // once it has been running for a bit
+    size_t viewChunks = static_cast<size_t>((2 * renderDistance + 1) * (2 * renderDistance + 1));
+    loadedChunks.reserve(viewChunks * 2);
+    chunksInQueue.reserve(viewChunks);
+    warmRecycledNodes<ChunkMap>(viewChunks * 2, [](size_t i) { return std::make_pair(std::make_pair(static_cast<int>(i), 0), static_cast<Chunk*>(nullptr)); });
+    warmRecycledNodes<decltype(chunksInQueue)>(viewChunks, [](size_t i) { return std::make_pair(static_cast<int>(i), 0); });
+    BufferSubAllocator::reserveBlocks(viewChunks * 2);
+    // and Render's lists; it runs after the unload, with at most a view loaded
+    chunkBounds.reserve(viewChunks);
+    boundsChunks.reserve(viewChunks);
+    chunkVisible.reserve(viewChunks);
+    reachableChunks.reserve(viewChunks);
+    visibleChunks.reserve(viewChunks);
+    chunkVisibility.reserve(renderDistance);
+    renderQueue.reserve(viewChunks);
+    chunkEpochs.setReclaimer([](Chunk* retiredChunk) { chunkPool.release(retiredChunk); });
+    chunkEpochs.reserve(viewChunks * 2);
 
     
-    int framebufferWidth, framebufferHeight;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    int framebufferWidth = width, framebufferHeight = height;
+    if (!headless) {
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
     std::cout << "Framebuffer width: " << framebufferWidth << " height: " << framebufferHeight << std::endl;
     glViewport(0, 0, framebufferWidth, framebufferHeight);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
+    // Chunk quads and horizon triangles are counter-clockwise from the front
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
     glEnable(GL_DEPTH_TEST);
 
-    glfwSetWindowUserPointer(window, this);
-    glfwSetMouseButtonCallback(window, mouse_click_callback);
-    glfwSetCursorPosCallback(window, mouse_button_callback);
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!headless) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetMouseButtonCallback(window, mouse_click_callback);
+        glfwSetCursorPosCallback(window, mouse_button_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
     glGenVertexArrays(1, &rayVAO);
     glGenBuffers(1, &rayVBO);
 
@@ -243,10 +377,24 @@ void Game::Init() {
 
     // chunk = new Chunk(16,16,16, glm::vec3(0.0f, 0.0f, 0.0f) , this); ;
     camera = new Camera();
-    shaderProgram = shaderLoader->loadShaders("VertShader.vertexshader", "FragShader.fragmentshader");    
+    const char* vertexShader = meshFormat == MeshFormat::FaceRecords ? "VertShaderFaces.vertexshader" : "VertShader.vertexshader";
+    shaderProgram = shaderLoader->loadShaders(vertexShader, "FragShader.fragmentshader");
     this->textureManager = new TextureManager();
     this->textureID = textureManager->loadTexture("pics/spritesheet.png");
     cout << "Texture ID: " << textureID << endl;
+    this->atlasTextureID = textureManager->loadTexture("pics/mcspritesheet.png");
+    // Build every chunk a full view holds up front, with room for the ones in
+    // flight and waiting on their epoch, so the pool doesn't grow while streaming
+    size_t fullChunks = static_cast<size_t>((2 * LOD_RING_END[0] + 1) * (2 * LOD_RING_END[0] + 1));
+    chunkPool.reserve(fullChunks * 2, viewChunks + viewChunks / 2, CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, this, shaderProgram, *textureManager);
+    if (meshFormat == MeshFormat::FaceRecords) {
+        renderQueue.init(shaderProgram, atlasTextureID, faceArena);
+    } else {
+        renderQueue.init(shaderProgram, atlasTextureID, meshArena);
+    }
+    GLuint horizonProgram = shaderLoader->loadShaders("VertShaderHorizon.vertexshader", "FragShaderHorizon.fragmentshader");
+    int horizonBlocks = renderDistance * CHUNK_SIZE * HORIZON_DISTANCE_SCALE;
+    horizonRenderer.init(horizonProgram, (horizonBlocks + HorizonRenderer::TILE_BLOCKS - 1) / HorizonRenderer::TILE_BLOCKS, CHUNK_SIZE / 2);
 }
 void Game::drawRay(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float length) {
     glm::vec3 rayEnd = rayOrigin + rayDirection * length;
@@ -280,44 +428,117 @@ void Game::Update(float deltaTime) {
 
     UpdateChunks();
 }
-std::unordered_set<std::pair<int, int>> chunksInQueue;
 
 
 void Game::UpdateChunks() {
+    PROFILE_ZONE("Game::UpdateChunks");
     int playerChunkX = static_cast<int>(camera->cameraPos.x) / CHUNK_SIZE;
     int playerChunkZ = static_cast<int>(camera->cameraPos.z) / CHUNK_SIZE;
 
-    int renderDistance = 3;
+    // Find chunks that are missing or meshed at the wrong level of detail,
+    // and queue them nearest first
+    struct ChunkRequest {
+        int distance, x, z, lod;
+    };
+    static std::vector<ChunkRequest> requests;
+    requests.clear();
     for (int x = playerChunkX - renderDistance; x < playerChunkX + renderDistance; x++){
         for (int z = playerChunkZ - renderDistance; z < playerChunkZ + renderDistance; z++){
             std::pair<int, int> chunkPos = {x, z};
-
-            if (loadedChunks.find(chunkPos) == loadedChunks.end() && chunksInQueue.find(chunkPos) == chunksInQueue.end()) {
-                // Only enqueue if the chunk is neither loaded nor already in the queue
-                std::cout << "Enqueueing new chunk at: (" << x << ", " << z << ")" << std::endl;
-                chunksInQueue.insert(chunkPos); // Mark chunk as enqueued
-                
-                threadPool.enqueueTask([this, chunkPos, x, z]() {
-                    Chunk* newChunk = new Chunk(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, glm::vec3(x * CHUNK_SIZE, 0.0f, z * CHUNK_SIZE), this, shaderProgram, *textureManager);
-                    
-                    std::lock_guard<std::mutex> lock(chunkMutex);
-                    chunksToAdd.push_back(newChunk);
-
-                    chunksInQueue.erase(chunkPos); // Remove from the queue once processed
-                });
+            if (chunksInQueue.find(chunkPos) != chunksInQueue.end()) {
+                continue;
+            }
+            int distance = std::max(std::abs(x - playerChunkX), std::abs(z - playerChunkZ));
+            auto loaded = loadedChunks.find(chunkPos);
+            int currentLod = loaded != loadedChunks.end() ? loaded->second->lodLevel : -1;
+            int lod = chooseLod(distance, currentLod);
+            if (lod != currentLod) {
+                requests.push_back({distance, x, z, lod});
             }
         }
     }
+    std::sort(requests.begin(), requests.end(), [](const ChunkRequest& a, const ChunkRequest& b) { return a.distance < b.distance; });
+    for (const ChunkRequest& request : requests) {
+        uint32_t slot;
+        if (!freeChunkJobs.tryPop(slot)) {
+            break;  // every slot is in flight, the rest wait for a later frame
+        }
+        int x = request.x, z = request.z, lod = request.lod;
+        LOG_DEBUG("Enqueueing new chunk at: (", x, ", ", z, ") lod ", lod);
+        chunksInQueue.insert({x, z}); // Mark chunk as enqueued
+        chunkJobs[slot] = {x, z, lod, loadedChunks.find({x, z}) != loadedChunks.end(), FrameStats::nowSeconds()};
+
+        threadPool.enqueueTask([this, slot]() {
+            double startedAt = FrameStats::nowSeconds();
+            ChunkJob job = chunkJobs[slot];
+            freeChunkJobs.push(slot);
+            int x = job.x, z = job.z, lod = job.lod;
+            // Meshing may look at neighbor chunks, keep them alive until we're done
+            EpochGuard guard(chunkEpochs);
+            Chunk* newChunk = chunkPool.acquire(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, glm::vec3(x * CHUNK_SIZE, 0.0f, z * CHUNK_SIZE), this, shaderProgram, *textureManager, lod);
+            ChunkTrace& trace = newChunk->trace;
+            trace.x = x;
+            trace.z = z;
+            trace.lod = lod;
+            trace.remesh = job.remesh;
+            trace.stamp(ChunkStage::Requested, job.requestedAt);
+            trace.stamp(ChunkStage::Started, startedAt);
+            newChunk->stageMesh(stagingRing);  // falls back to a direct upload if the ring is full
+            trace.stamp(ChunkStage::Queued, FrameStats::nowSeconds());
+            chunksToAdd.push(newChunk);
+        });
+    }
 
-    std::lock_guard<std::mutex> lock(chunkMutex);
-    while (!chunksToAdd.empty()) {
-
+    Chunk* readyChunk;
+    size_t generated = 0;
+    while (chunksToAdd.tryPop(readyChunk)) {
+        uploadScheduler.push(readyChunk);
+        generated++;
+    }
 
-        Chunk* newChunk = chunksToAdd.front();
-        chunksToAdd.pop_front();
-        newChunk->setupMesh();
-        loadedChunks[{static_cast<int>(newChunk->position.x / CHUNK_SIZE), static_cast<int>(newChunk->position.z / CHUNK_SIZE)}] = newChunk;
-        cout << "Loaded chunk at " << newChunk->position.x << " " << newChunk->position.z << endl;
+    // Chunks we flew past before they got uploaded are thrown away
+    static std::vector<Chunk*> discarded;  // reused every frame
+    discarded.clear();
+    discarded.reserve(static_cast<size_t>((2 * renderDistance + 1) * (2 * renderDistance + 1)));  // all of chunksInQueue at most
+    uploadScheduler.discardIf([&](const Chunk* pendingChunk) {
+        int x = static_cast<int>(pendingChunk->position.x / CHUNK_SIZE);
+        int z = static_cast<int>(pendingChunk->position.z / CHUNK_SIZE);
+        return x < playerChunkX - renderDistance || x > playerChunkX + renderDistance || z < playerChunkZ - renderDistance || z > playerChunkZ + renderDistance;
+    }, discarded);
+    for (Chunk* discardedChunk : discarded) {
+        chunksInQueue.erase({static_cast<int>(discardedChunk->position.x / CHUNK_SIZE), static_cast<int>(discardedChunk->position.z / CHUNK_SIZE)});
+        ChunkLifecycle::unloaded(discardedChunk->trace);
+        chunkEpochs.retire(discardedChunk);
+    }
+    frameStats.addStreaming(generated, discarded.size());
+
+    // Upload the nearest ready meshes within this frame's budget
+    static std::vector<Chunk*> uploaded;
+    uploaded.clear();
+    stagingRing.collect();
+    uploadScheduler.process(camera->cameraPos, uploaded);
+    stagingRing.fenceFrame();
+    frameStats.addUploads(uploaded.size(), uploadScheduler.lastFrameBytes());
+    double uploadedAt = FrameStats::nowSeconds();
+    for (Chunk* newChunk : uploaded) {
+        newChunk->trace.stamp(ChunkStage::Uploaded, uploadedAt);
+        ChunkLifecycle::uploaded(newChunk->trace);
+        std::pair<int, int> chunkPos = {static_cast<int>(newChunk->position.x / CHUNK_SIZE), static_cast<int>(newChunk->position.z / CHUNK_SIZE)};
+        // A chunk remeshed at another level of detail replaces the old one
+        Chunk* replaced = nullptr;
+        {
+            std::unique_lock<std::shared_mutex> mapLock(loadedChunksMutex);
+            Chunk*& slot = loadedChunks[chunkPos];
+            replaced = slot;
+            slot = newChunk;
+        }
+        if (replaced != nullptr) {
+            replaced->trace.stamp(ChunkStage::Unloaded, uploadedAt);
+            ChunkLifecycle::unloaded(replaced->trace);
+            chunkEpochs.retire(replaced);
+        }
+        chunksInQueue.erase(chunkPos); // Remove from the queue once loaded
+        LOG_DEBUG("Loaded chunk at ", newChunk->position.x, " ", newChunk->position.z);
     }
 
 
@@ -327,13 +548,66 @@ void Game::UpdateChunks() {
         int x = chunkPos.first;
         int z = chunkPos.second;
         if (x < playerChunkX - renderDistance || x > playerChunkX + renderDistance || z < playerChunkZ - renderDistance || z > playerChunkZ + renderDistance) {
-            delete it->second;
-            it = loadedChunks.erase(it);
+            // Unlink first, then retire: a worker may still be meshing against it
+            Chunk* unloaded = it->second;
+            {
+                std::unique_lock<std::shared_mutex> mapLock(loadedChunksMutex);
+                it = loadedChunks.erase(it);
+            }
+            unloaded->trace.stamp(ChunkStage::Unloaded, FrameStats::nowSeconds());
+            ChunkLifecycle::unloaded(unloaded->trace);
+            chunkEpochs.retire(unloaded);
         } else {
             ++it;
         }
     }
 
+    // Free a few retired chunks per frame once no in-flight job can see them
+    chunkEpochs.reclaim(MAX_CHUNKS_RECLAIMED_PER_FRAME);
+    ChunkMeshArena::Stats arenaStats;
+    if (meshFormat == MeshFormat::FaceRecords) {
+        faceArena.maintain();
+        arenaStats = faceArena.stats();
+    } else {
+        meshArena.maintain();
+        arenaStats = meshArena.stats();
+    }
+    frameStats.setMeshMemory(arenaStats.bytesInUse, arenaStats.bytesReserved, arenaStats.vertexFragmentation);
+    if (++framesSinceMemorySample >= MEMORY_SAMPLE_FRAMES) {
+        SampleMemory();
+    }
+
+    // Far terrain fills in past the loaded chunks
+    glm::vec2 voxelMin((playerChunkX - renderDistance) * CHUNK_SIZE - 0.5f, (playerChunkZ - renderDistance) * CHUNK_SIZE - 0.5f);
+    glm::vec2 voxelMax((playerChunkX + renderDistance) * CHUNK_SIZE - 0.5f, (playerChunkZ + renderDistance) * CHUNK_SIZE - 0.5f);
+    horizonRenderer.update(camera->cameraPos, voxelMin, voxelMax, threadPool);
+
+}
+
+
+void Game::SampleMemory() {
+    framesSinceMemorySample = 0;
+    ChunkMemory total, largest;
+    for (const auto& loaded : loadedChunks) {
+        ChunkMemory usage = loaded.second->memoryUsage();
+        total.add(usage);
+        if (usage.ram() > largest.ram()) {
+            largest = usage;
+        }
+    }
+    MemoryStats::set(MemoryCategory::Voxels, total.voxels);
+    MemoryStats::set(MemoryCategory::ChunkMeshes, total.cpuMesh);
+    MemoryStats::set(MemoryCategory::ChunkOther, total.other);
+    MemoryStats::setChunks(loadedChunks.size(), total, largest);
+
+    // Retired chunks can't be looked at safely, count them as average ones
+    size_t meanChunkBytes = loadedChunks.empty() ? 0 : total.ram() / loadedChunks.size();
+    MemoryStats::set(MemoryCategory::PendingChunks, uploadScheduler.pendingBytes() + chunkEpochs.pendingCount() * meanChunkBytes);
+    MemoryStats::set(MemoryCategory::PooledChunks, chunkPool.pooledBytes());
+    MemoryStats::set(MemoryCategory::GpuMeshes, meshFormat == MeshFormat::FaceRecords ? faceArena.stats().bytesReserved : meshArena.stats().bytesReserved);
+    MemoryStats::set(MemoryCategory::GpuStaging, stagingRing.capacityBytes());
+    MemoryStats::set(MemoryCategory::GpuHorizon, horizonRenderer.gpuBytes());
+    MemoryStats::endSample();
 }
 
 
@@ -342,13 +616,14 @@ bool Game::castRayForVoxel(const glm::vec3& rayOrigin, const glm::vec3& rayDirec
     for (const auto& chunkPair : loadedChunks) {
         if (chunkPair.second->position.x <= rayOrigin.x && rayOrigin.x < chunkPair.second->position.x + CHUNK_SIZE &&
             chunkPair.second->position.z <= rayOrigin.z && rayOrigin.z < chunkPair.second->position.z + CHUNK_SIZE) {
-            cout << "Ray is in chunk at " << chunkPair.first.first << " " << chunkPair.first.second << endl;
+            LOG_DEBUG("Ray is in chunk at ", chunkPair.first.first, " ", chunkPair.first.second);
             return raycast(rayOrigin, rayDirection, *chunkPair.second, hitVoxel, maxDistance);
         }
     }
     
 }
 void Game::Render() {
+    PROFILE_ZONE("Game::Render");
     // Enable wireframe mode for debugging (if needed)
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); 
 
@@ -362,53 +637,201 @@ void Game::Render() {
     glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 1.0f);  // White light (corrected)
     glm::vec3 ambientColor = glm::vec3(0.53f, 0.81f, 0.98f);  // Light sky blue as ambient
 
-    glUseProgram(shaderProgram);
-
-    // Pass light information to the shader
-    GLuint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-    GLuint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLuint ambientColorLoc = glGetUniformLocation(shaderProgram, "ambientColor");
-
-    glUniform3fv(lightDirLoc, 1, glm::value_ptr(lightDir));
-    glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
-    glUniform3fv(ambientColorLoc, 1, glm::value_ptr(ambientColor));
-
-
-
-    // Bind the texture atlas once (assuming you have the texture atlas loaded in texture unit 0)
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureManager->loadTexture("pics/mcspritesheet.png"));
-    GLint textureUniformLoc = glGetUniformLocation(shaderProgram, "blockTexture");
-    glUniform1i(textureUniformLoc, 0);  // Texture unit 0
-
     // Update the view matrix from the camera
     glm::mat4 view = camera->getViewMatrix();
     
     // Set the projection matrix for 3D perspective
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-
-    // Render all chunks
+    // The far plane follows the render distance (1.5 covers the diagonal)
+    float farPlane = (renderDistance + 1) * CHUNK_SIZE * 1.5f;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, farPlane);
+
+    // Far terrain first with its own deeper projection, then clear depth so
+    // the chunks always draw over it
+    glm::mat4 horizonProjection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 1.0f, horizonRenderer.reach() * 1.5f);
+    Frustum horizonFrustum(horizonProjection * view);
+    size_t horizonTiles = horizonRenderer.draw(view, horizonProjection, horizonFrustum, camera->cameraPos, lightDir, lightColor, ambientColor);
+    frameStats.addHorizon(horizonTiles, horizonTiles * horizonRenderer.trianglesPerTile());
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    // Frustum cull all chunks in one batch, then render the visible ones
+    chunkBounds.clear();
+    boundsChunks.clear();
     for (const auto& chunkPair : loadedChunks) {
-        chunkPair.second->render(shaderProgram, view, projection);
+        chunkBounds.add(chunkPair.second->boundsMin(), chunkPair.second->boundsMax());
+        boundsChunks.push_back(chunkPair.second);
+    }
+    Frustum frustum(projection * view);
+    size_t drawn = chunkBounds.cull(frustum, chunkVisible);
+    frameStats.addCulling(drawn, boundsChunks.size() - drawn);
+    static unsigned int frameIndex = 0;
+    frameIndex++;
+    for (size_t i = 0; i < boundsChunks.size(); i++) {
+        if (chunkVisible[i]) {
+            boundsChunks[i]->visibleFrame = frameIndex;
+        }
     }
 
-    // Swap buffers to display the rendered frame
-    glfwSwapBuffers(window);
+    // Walk out from the camera through connected air to skip sealed caves
+    reachableChunks.clear();
+    chunkVisibility.collect(loadedChunks, camera->cameraPos, frustum, frameIndex, renderDistance, reachableChunks);
+    frameStats.addCaveCulling(drawn - std::min(drawn, reachableChunks.size()));
+
+    // Then occlusion cull what's left against the nearest chunks' solid boxes
+    visibleChunks.clear();
+    for (Chunk* reachable : reachableChunks) {
+        glm::vec3 center = (reachable->boundsMin() + reachable->boundsMax()) * 0.5f;
+        glm::vec3 toCamera = center - camera->cameraPos;
+        visibleChunks.push_back({glm::dot(toCamera, toCamera), reachable});
+    }
+    std::sort(visibleChunks.begin(), visibleChunks.end(),
+              [](const std::pair<float, Chunk*>& a, const std::pair<float, Chunk*>& b) { return a.first < b.first; });
+    occlusionCuller.beginFrame(projection * view);
+    for (size_t i = 0; i < visibleChunks.size() && i < MAX_OCCLUDER_CHUNKS; i++) {
+        const std::vector<glm::vec3>& boxes = visibleChunks[i].second->occluderBoxes;
+        for (size_t b = 0; b + 1 < boxes.size(); b += 2) {
+            occlusionCuller.addOccluder(boxes[b], boxes[b + 1]);
+        }
+    }
+    occlusionCuller.rasterize();
+
+    size_t occluded = 0;
+    size_t chunkTriangles = 0, facingTriangles = 0;
+    for (const auto& visibleChunk : visibleChunks) {
+        Chunk* visible = visibleChunk.second;
+        if (occlusionCuller.testBox(visible->boundsMin(), visible->boundsMax())) {
+            facingTriangles += visible->submit(renderQueue, atlasTextureID, camera->cameraPos);
+            chunkTriangles += visible->meshTriangleCount();
+            ChunkTrace& trace = visible->trace;
+            if (!trace.reached(ChunkStage::FirstDrawn) && trace.reached(ChunkStage::Requested)) {
+                trace.stamp(ChunkStage::FirstDrawn, FrameStats::nowSeconds());
+                ChunkLifecycle::drawn(trace);
+                // Load latency is only measured for chunks that weren't drawn at all yet
+                if (!trace.remesh) {
+                    frameStats.addChunkLoadLatency(static_cast<float>((trace.at[static_cast<int>(ChunkStage::FirstDrawn)] - trace.at[static_cast<int>(ChunkStage::Requested)]) * 1000.0));
+                }
+            }
+        } else {
+            occluded++;
+        }
+    }
+    frameStats.addOcclusion(occluded);
+    frameStats.addChunkTriangles(facingTriangles, chunkTriangles - facingTriangles);
+
+    // Program, atlas and per-frame uniforms are bound once for all chunks
+    RenderQueue::PerFrame perFrame;
+    perFrame.view = view;
+    perFrame.projection = projection;
+    perFrame.lightDir = glm::vec4(lightDir, 0.0f);
+    perFrame.lightColor = glm::vec4(lightColor, 0.0f);
+    perFrame.ambientColor = glm::vec4(ambientColor, 0.0f);
+    frameStats.addDrawCalls(renderQueue.flush(perFrame) + (horizonTiles > 0 ? 1 : 0));
+    frameStats.addLoadedChunks(loadedChunks.size());
+
+    if (headless) {
+        // Nothing to present; wait for the frame so its GPU time counts too
+        glFinish();
+    } else {
+        // Swap buffers to display the rendered frame
+        glfwSwapBuffers(window);
+    }
 }
 
 
 
 
+void Game::playScript(const CameraScript& script, int frames) {
+    cameraScript = script;
+    scriptFrames = frames;
+    // One window covering the whole run, so the summary's percentiles see every frame
+    frameStats = FrameStats(static_cast<size_t>(frames));
+}
+
+void Game::enableHeadless() {
+    headless = true;
+}
+
+void Game::setUploadBudget(float millis, size_t bytes) {
+    uploadScheduler.maxMillisPerFrame = millis > 0.0f ? millis : FLT_MAX;
+    uploadScheduler.maxBytesPerFrame = bytes > 0 ? bytes : SIZE_MAX;
+}
+
+void Game::recordPath(const std::string& path) {
+    recordingPath = path;
+    recording.clear();
+    recording.setSeed(terrainSeed());
+}
+
+bool Game::writePoolTelemetry(const std::string& path) {
+    return threadPool.writeTelemetryJson(path);
+}
+
 void Game::Run() {
+    Profiler::setThreadName("main");
     Init();
 
+    if (scriptFrames > 0) {
+        // Time steps a fixed amount per frame, so the camera is in the same
+        // place on the same frame however long frames take
+        for (int frame = 0; frame < scriptFrames; frame++) {
+            if (!headless && glfwWindowShouldClose(window)) {
+                break;
+            }
+            PROFILE_ZONE("Frame");
+            frameStats.beginFrame();
+            AllocTracker::beginFrame();
+            glm::vec3 position;
+            float yaw, pitch;
+            cameraScript.sample(frame * SCRIPT_FRAME_SECONDS, position, yaw, pitch);
+            camera->setPose(position, yaw, pitch);
+            AllocTracker::Counts beforeRender = AllocTracker::thisThread();
+            Render();
+            AllocTracker::Counts renderAllocations = AllocTracker::thisThread() - beforeRender;
+            Update(SCRIPT_FRAME_SECONDS);
+            AllocTracker::Counts streamingAllocations = AllocTracker::thisThread() - beforeRender - renderAllocations;
+            if (!headless) {
+                glfwPollEvents();
+            }
+            AllocTracker::endFrame(renderAllocations, streamingAllocations);
+            frameStats.endFrame();
+        }
+        frameStats.summary();
+        SampleMemory();
+        MemoryStats::print();
+        ChunkLifecycle::printSummary();
+        ThreadPool::Telemetry pool = threadPool.telemetry();
+        std::cout << "pool tasks " << pool.completed << " (peak queue " << pool.peakQueueDepth << "), wait us p50 "
+                  << pool.waitNanos.percentile(50.0) / 1000 << " p99 " << pool.waitNanos.percentile(99.0) / 1000
+                  << ", run us p50 " << pool.runNanos.percentile(50.0) / 1000 << " p99 " << pool.runNanos.percentile(99.0) / 1000
+                  << ", workers busy " << static_cast<int>(pool.utilization * 100.0) << "%" << std::endl;
+        AllocTracker::printSummary();
+        return;
+    }
+
+    float recordStart = static_cast<float>(glfwGetTime());
+    float nextKeyframe = 0.0f;
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("Frame");
+        frameStats.beginFrame();
+        AllocTracker::beginFrame();
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        AllocTracker::Counts beforeRender = AllocTracker::thisThread();
         Render();
+        AllocTracker::Counts renderAllocations = AllocTracker::thisThread() - beforeRender;
         Update(deltaTime);
+        AllocTracker::Counts streamingAllocations = AllocTracker::thisThread() - beforeRender - renderAllocations;
         ProcessInput(deltaTime);
         glfwPollEvents();
+        if (!recordingPath.empty() && currentFrame - recordStart >= nextKeyframe) {
+            recording.addKeyframe(currentFrame - recordStart, camera->cameraPos, camera->getYaw(), camera->getPitch());
+            nextKeyframe = currentFrame - recordStart + RECORD_INTERVAL_SECONDS;
+        }
+        AllocTracker::endFrame(renderAllocations, streamingAllocations);
+        frameStats.endFrame();
+        frameStats.report();
     }
-}
\ No newline at end of file
+    if (!recordingPath.empty() && recording.save(recordingPath)) {
+        std::cout << "Recorded " << recording.keyframeCount() << " camera keyframes to " << recordingPath << std::endl;
+    }
+}
@@ -0,0 +1,138 @@
+#include "HeadlessContext.hpp"
+#include <iostream>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext() {
+}
+
+HeadlessContext::~HeadlessContext() {
+    destroy();
+}
+
+#ifdef HAVE_EGL
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+void* HeadlessContext::getProcAddress(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+bool HeadlessContext::create(int width, int height) {
+    // Surfaceless needs no window system at all; fall back to the default
+    // display for EGL implementations without it
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    if (getPlatformDisplay != nullptr) {
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+        std::cerr << "HeadlessContext: no EGL display" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "HeadlessContext: EGL has no desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // No surface is ever made, so any config that can do GL will do (or none at all)
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount);
+
+    // The newest core profile we make use of, then the 3.3 baseline
+    const EGLint versions[2][2] = {{4, 5}, {3, 3}};
+    EGLContext eglContext = EGL_NO_CONTEXT;
+    for (const EGLint* version : versions) {
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE};
+        eglContext = eglCreateContext(eglDisplay, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+        if (eglContext != EGL_NO_CONTEXT) {
+            break;
+        }
+    }
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+        std::cerr << "HeadlessContext: could not create a GL 3.3 core context (EGL error " << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        destroy();
+        return false;
+    }
+    context = eglContext;
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(getProcAddress))) {
+        std::cerr << "HeadlessContext: failed to load GL" << std::endl;
+        destroy();
+        return false;
+    }
+    std::cout << "Headless GL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+    return createFramebuffer(width, height);
+}
+
+void HeadlessContext::destroy() {
+    if (context != nullptr) {
+        if (fbo != 0) {
+            glDeleteFramebuffers(1, &fbo);
+            GLuint renderbuffers[2] = {colorBuffer, depthBuffer};
+            glDeleteRenderbuffers(2, renderbuffers);
+            fbo = colorBuffer = depthBuffer = 0;
+        }
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        context = nullptr;
+    }
+    if (display != nullptr) {
+        eglTerminate(display);
+        display = nullptr;
+    }
+}
+
+#else
+
+void* HeadlessContext::getProcAddress(const char*) {
+    return nullptr;
+}
+
+bool HeadlessContext::create(int, int) {
+    std::cerr << "HeadlessContext: built without EGL, headless mode needs the Linux build" << std::endl;
+    return false;
+}
+
+void HeadlessContext::destroy() {
+}
+
+#endif
+
+bool HeadlessContext::createFramebuffer(int width, int height) {
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "HeadlessContext: offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,268 @@
+#include "HorizonRenderer.hpp"
+#include "Profiler.hpp"
+#include "Frustum.hpp"
+#include "TerrainNoise.hpp"
+#include "ThreadPool.hpp"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+    // Roughly what each biome's surface looks like from far away
+    glm::vec3 biomeColor(BiomeType biome) {
+        switch (biome) {
+            case BiomeType::Desert:    return glm::vec3(0.86f, 0.80f, 0.56f);
+            case BiomeType::Plains:    return glm::vec3(0.42f, 0.62f, 0.27f);
+            case BiomeType::Forest:    return glm::vec3(0.24f, 0.45f, 0.18f);
+            case BiomeType::Mountains: return glm::vec3(0.52f, 0.52f, 0.52f);
+        }
+        return glm::vec3(0.5f);
+    }
+}
+
+HorizonRenderer::HorizonRenderer() : finished(MAX_TILES_IN_FLIGHT) {
+    const int SAMPLES = TILE_GRID + 2;
+    for (TileJob& job : jobs) {
+        job.heights.resize(SAMPLES * SAMPLES);
+        job.biomes.resize(SAMPLES * SAMPLES);
+        job.vertices.resize(TILE_GRID * TILE_GRID);
+    }
+}
+
+HorizonRenderer::~HorizonRenderer() {
+}
+
+void HorizonRenderer::init(GLuint program, int tileRadius, int maxSurfaceHeight) {
+    this->program = program;
+    this->tileRadius = tileRadius;
+    this->maxSurfaceHeight = maxSurfaceHeight;
+    viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+    cameraPosLocation = glGetUniformLocation(program, "cameraPos");
+    voxelAreaLocation = glGetUniformLocation(program, "voxelArea");
+    lightDirLocation = glGetUniformLocation(program, "lightDir");
+    lightColorLocation = glGetUniformLocation(program, "lightColor");
+    skyColorLocation = glGetUniformLocation(program, "skyColor");
+    fogRangeLocation = glGetUniformLocation(program, "fogRange");
+
+    // Every tile has the same grid, so they all share one index buffer
+    std::vector<uint16_t> indices;
+    for (int i = 0; i + 1 < TILE_GRID; i++) {
+        for (int j = 0; j + 1 < TILE_GRID; j++) {
+            uint16_t corner = static_cast<uint16_t>(i * TILE_GRID + j);
+            uint16_t stepX = static_cast<uint16_t>(corner + TILE_GRID);
+            // Counter-clockwise seen from above
+            indices.insert(indices.end(), {corner, static_cast<uint16_t>(corner + 1), stepX});
+            indices.insert(indices.end(), {stepX, static_cast<uint16_t>(corner + 1), static_cast<uint16_t>(stepX + 1)});
+        }
+    }
+    indexCount = static_cast<GLsizei>(indices.size());
+
+    // One slot per tile that can be in range at once
+    slotsPerSide = 2 * tileRadius + 1;
+    size_t slots = static_cast<size_t>(slotsPerSide) * slotsPerSide;
+    this->slots.assign(slots, Slot());
+    residentCount = 0;
+    missing.reserve(slots);
+    counts.reserve(slots);
+    offsets.reserve(slots);
+    baseVertices.reserve(slots);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, slots * TILE_GRID * TILE_GRID * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    bufferBytes = slots * TILE_GRID * TILE_GRID * sizeof(Vertex) + indices.size() * sizeof(uint16_t);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+}
+
+void HorizonRenderer::shutdown() {
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        vao = vbo = ebo = 0;
+        bufferBytes = 0;
+    }
+    slots.assign(slots.size(), Slot());
+    residentCount = 0;
+}
+
+bool HorizonRenderer::wanted(const TileKey& tile, const TileKey& center) const {
+    if (std::abs(tile.first - center.first) > tileRadius || std::abs(tile.second - center.second) > tileRadius) {
+        return false;
+    }
+    // Tiles the voxel chunks cover completely would never show
+    glm::vec2 tileMin(tile.first * TILE_BLOCKS, tile.second * TILE_BLOCKS);
+    glm::vec2 tileMax = tileMin + glm::vec2(TILE_BLOCKS);
+    return !(tileMin.x >= voxelMin.x && tileMax.x <= voxelMax.x && tileMin.y >= voxelMin.y && tileMax.y <= voxelMax.y);
+}
+
+// Any n consecutive tiles on an axis map to n different slots, so every
+// tile in range has its own
+size_t HorizonRenderer::slotFor(const TileKey& tile) const {
+    int x = ((tile.first % slotsPerSide) + slotsPerSide) % slotsPerSide;
+    int z = ((tile.second % slotsPerSide) + slotsPerSide) % slotsPerSide;
+    return static_cast<size_t>(x) * slotsPerSide + z;
+}
+
+bool HorizonRenderer::inFlight(const TileKey& tile) const {
+    for (const TileJob& job : jobs) {
+        if (job.busy && job.tileX == tile.first && job.tileZ == tile.second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HorizonRenderer::buildTile(TileJob& job) const {
+    PROFILE_ZONE("HorizonRenderer::buildTile");
+    const siv::PerlinNoise& noise = terrainNoise();
+    int tileX = job.tileX, tileZ = job.tileZ;
+
+    // Heights with a one sample border, so normals on the tile edge match the next tile's
+    const int SAMPLES = TILE_GRID + 2;
+    std::vector<float>& heights = job.heights;
+    std::vector<BiomeType>& biomes = job.biomes;
+    for (int i = 0; i < SAMPLES; i++) {
+        for (int j = 0; j < SAMPLES; j++) {
+            int worldX = tileX * TILE_BLOCKS + (i - 1) * TILE_STEP;
+            int worldZ = tileZ * TILE_BLOCKS + (j - 1) * TILE_STEP;
+            SurfaceSample surface = sampleSurface(noise, worldX, worldZ, maxSurfaceHeight);
+            heights[i * SAMPLES + j] = surface.height + 0.5f;   // top of the surface block
+            biomes[i * SAMPLES + j] = surface.biome;
+        }
+    }
+
+    for (int i = 0; i < TILE_GRID; i++) {
+        for (int j = 0; j < TILE_GRID; j++) {
+            int sample = (i + 1) * SAMPLES + (j + 1);
+            Vertex& vertex = job.vertices[i * TILE_GRID + j];
+            vertex.position = glm::vec3(tileX * TILE_BLOCKS + i * TILE_STEP, heights[sample], tileZ * TILE_BLOCKS + j * TILE_STEP);
+            vertex.normal = glm::normalize(glm::vec3(heights[sample - SAMPLES] - heights[sample + SAMPLES], 2.0f * TILE_STEP,
+                                                     heights[sample - 1] - heights[sample + 1]));
+            vertex.color = biomeColor(biomes[sample]);
+        }
+    }
+}
+
+void HorizonRenderer::update(const glm::vec3& cameraPos, const glm::vec2& voxelMin, const glm::vec2& voxelMax, ThreadPool& pool) {
+    PROFILE_ZONE("HorizonRenderer::update");
+    this->voxelMin = voxelMin;
+    this->voxelMax = voxelMax;
+    TileKey center(static_cast<int>(std::floor(cameraPos.x / TILE_BLOCKS)), static_cast<int>(std::floor(cameraPos.z / TILE_BLOCKS)));
+
+    // Drop tiles we moved away from (or that the voxel area now covers)
+    for (Slot& slot : slots) {
+        if (slot.resident && !wanted(TileKey(slot.tileX, slot.tileZ), center)) {
+            slot.resident = false;
+            residentCount--;
+        }
+    }
+
+    // Upload finished tiles that are still wanted
+    uint32_t jobIndex;
+    while (finished.tryPop(jobIndex)) {
+        TileJob& job = jobs[jobIndex];
+        TileKey key(job.tileX, job.tileZ);
+        size_t slotIndex = slotFor(key);
+        Slot& slot = slots[slotIndex];
+        // The slot is free: a tile in range owns it alone, and out of range ones were just dropped
+        if (wanted(key, center) && !slot.resident) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, slotIndex * TILE_GRID * TILE_GRID * sizeof(Vertex),
+                            job.vertices.size() * sizeof(Vertex), job.vertices.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            slot.tileX = key.first;
+            slot.tileZ = key.second;
+            slot.resident = true;
+            residentCount++;
+        }
+        job.busy = false;
+        jobsInFlight--;
+    }
+
+    // Queue the nearest missing tiles
+    if (jobsInFlight >= MAX_TILES_IN_FLIGHT) {
+        return;
+    }
+    missing.clear();
+    for (int x = center.first - tileRadius; x <= center.first + tileRadius; x++) {
+        for (int z = center.second - tileRadius; z <= center.second + tileRadius; z++) {
+            TileKey key(x, z);
+            const Slot& slot = slots[slotFor(key)];
+            bool isResident = slot.resident && slot.tileX == x && slot.tileZ == z;
+            if (wanted(key, center) && !isResident && !inFlight(key)) {
+                missing.push_back({std::max(std::abs(x - center.first), std::abs(z - center.second)), key});
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end());
+    for (size_t i = 0; i < missing.size() && jobsInFlight < MAX_TILES_IN_FLIGHT; i++) {
+        uint32_t index = 0;
+        while (jobs[index].busy) {
+            index++;
+        }
+        TileJob& job = jobs[index];
+        job.tileX = missing[i].second.first;
+        job.tileZ = missing[i].second.second;
+        job.busy = true;
+        jobsInFlight++;
+        pool.enqueueTask([this, index]() {
+            buildTile(jobs[index]);
+            finished.push(index);
+        });
+    }
+}
+
+size_t HorizonRenderer::draw(const glm::mat4& view, const glm::mat4& projection, const Frustum& frustum, const glm::vec3& cameraPos,
+                             const glm::vec3& lightDir, const glm::vec3& lightColor, const glm::vec3& skyColor) {
+    PROFILE_ZONE("HorizonRenderer::draw");
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (!slots[i].resident) {
+            continue;
+        }
+        glm::vec3 tileMin(slots[i].tileX * TILE_BLOCKS, 0.0f, slots[i].tileZ * TILE_BLOCKS);
+        glm::vec3 tileMax = tileMin + glm::vec3(TILE_BLOCKS, maxSurfaceHeight + 1.0f, TILE_BLOCKS);
+        if (!frustum.intersectsBox(tileMin, tileMax)) {
+            continue;
+        }
+        counts.push_back(indexCount);
+        offsets.push_back(nullptr);
+        baseVertices.push_back(static_cast<GLint>(i * TILE_GRID * TILE_GRID));
+    }
+    if (counts.empty()) {
+        return 0;
+    }
+
+    float reach = this->reach();
+    glm::mat4 viewProjection = projection * view;
+    glUseProgram(program);
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniform3fv(cameraPosLocation, 1, glm::value_ptr(cameraPos));
+    glUniform4f(voxelAreaLocation, voxelMin.x, voxelMin.y, voxelMax.x, voxelMax.y);
+    glUniform3fv(lightDirLocation, 1, glm::value_ptr(lightDir));
+    glUniform3fv(lightColorLocation, 1, glm::value_ptr(lightColor));
+    glUniform3fv(skyColorLocation, 1, glm::value_ptr(skyColor));
+    glUniform2f(fogRangeLocation, reach * 0.5f, reach);
+    glBindVertexArray(vao);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(),
+                                  static_cast<GLsizei>(counts.size()), baseVertices.data());
+    glBindVertexArray(0);
+    return counts.size();
+}
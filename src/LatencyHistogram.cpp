@@ -0,0 +1,118 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other) {
+    clear();
+    merge(other);
+}
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other) {
+    if (this != &other) {
+        clear();
+        merge(other);
+    }
+    return *this;
+}
+
+int LatencyHistogram::bucketFor(uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) {
+        return static_cast<int>(nanos);
+    }
+    int magnitude = 63 - __builtin_clzll(nanos);
+    if (magnitude >= MAX_MAGNITUDE) {
+        return BUCKETS - 1;
+    }
+    int shift = magnitude - SUB_BUCKET_BITS;
+    int sub = static_cast<int>(nanos >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperEdge(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lower + (1ull << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    counts[bucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+    sumNanos.fetch_add(nanos, std::memory_order_relaxed);
+    uint64_t seen = maximum.load(std::memory_order_relaxed);
+    while (nanos > seen && !maximum.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        uint64_t n = other.counts[bucket].load(std::memory_order_relaxed);
+        if (n > 0) {
+            counts[bucket].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    sumNanos.fetch_add(other.sumNanos.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    uint64_t otherMax = other.maxNanos();
+    if (otherMax > maxNanos()) {
+        maximum.store(otherMax, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::clear() {
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        counts[bucket].store(0, std::memory_order_relaxed);
+    }
+    sumNanos.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t n = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        n += counts[bucket].load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+double LatencyHistogram::meanNanos() const {
+    uint64_t n = count();
+    return n > 0 ? static_cast<double>(sumNanos.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    // Rank of the sample we want, 1 based
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * n + 0.5));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += counts[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperEdge(bucket), maxNanos());
+        }
+    }
+    return maxNanos();
+}
+
+void LatencyHistogram::writeJson(std::ostream& out) const {
+    out << "{\"count\":" << count() << ",\"mean_ns\":" << static_cast<uint64_t>(meanNanos())
+        << ",\"p50_ns\":" << percentile(50.0) << ",\"p90_ns\":" << percentile(90.0)
+        << ",\"p99_ns\":" << percentile(99.0) << ",\"p999_ns\":" << percentile(99.9)
+        << ",\"max_ns\":" << maxNanos() << ",\"buckets\":[";
+    bool first = true;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        uint64_t n = counts[bucket].load(std::memory_order_relaxed);
+        if (n == 0) {
+            continue;
+        }
+        out << (first ? "" : ",") << "[" << bucketUpperEdge(bucket) << "," << n << "]";
+        first = false;
+    }
+    out << "]}";
+}
@@ -0,0 +1,68 @@
+#include "LodBenchmark.hpp"
+#include "Chunk.hpp"
+#include "ChunkLod.hpp"
+#include <cstdio>
+
+#define BENCH_CHUNK_SIZE 16
+#define SAMPLES_PER_RING 4
+// What the engine drew at full detail before level of detail existed
+#define FULL_DETAIL_DISTANCE 3
+
+namespace {
+    struct MeshCost {
+        double triangles = 0.0;
+        double bytes = 0.0;
+        double voxelBytes = 0.0;   // full voxels at level 0, only the cells above
+    };
+
+    MeshCost sampleRing(int distance, int lod, TextureManager& textures) {
+        MeshCost cost;
+        for (int sample = 0; sample < SAMPLES_PER_RING; sample++) {
+            glm::vec3 position(distance * BENCH_CHUNK_SIZE, 0.0f, (sample * 3 - distance) * BENCH_CHUNK_SIZE);
+            Chunk chunk(BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, position, nullptr, 0, textures, lod);
+            cost.triangles += chunk.meshTriangleCount();
+            cost.bytes += chunk.meshByteSize();
+            cost.voxelBytes += chunk.memoryUsage().voxels;
+        }
+        cost.triangles /= SAMPLES_PER_RING;
+        cost.bytes /= SAMPLES_PER_RING;
+        cost.voxelBytes /= SAMPLES_PER_RING;
+        return cost;
+    }
+}
+
+int runLodBenchmark(int renderDistance) {
+    TextureManager textures;
+    double lodTriangles = 0.0, lodBytes = 0.0;
+    double fullTriangles = 0.0, fullBytes = 0.0;
+    double oldTriangles = 0.0, oldBytes = 0.0;
+    double voxelBytes = 0.0, fullVoxelBytes = 0.0, oldVoxelBytes = 0.0;
+
+    printf("%4s %3s %6s %10s %10s %12s %10s %12s\n", "ring", "lod", "chunks", "tris/chunk", "KB/chunk", "ring tris", "ring KB", "full tris");
+    for (int distance = 0; distance < renderDistance; distance++) {
+        int chunks = distance == 0 ? 1 : 8 * distance;
+        int lod = lodForDistance(distance);
+        MeshCost cost = sampleRing(distance, lod, textures);
+        MeshCost full = lod == 0 ? cost : sampleRing(distance, 0, textures);
+
+        lodTriangles += cost.triangles * chunks;
+        lodBytes += cost.bytes * chunks;
+        fullTriangles += full.triangles * chunks;
+        fullBytes += full.bytes * chunks;
+        voxelBytes += cost.voxelBytes * chunks;
+        fullVoxelBytes += full.voxelBytes * chunks;
+        if (distance < FULL_DETAIL_DISTANCE) {
+            oldTriangles += full.triangles * chunks;
+            oldBytes += full.bytes * chunks;
+            oldVoxelBytes += full.voxelBytes * chunks;
+        }
+        printf("%4d %3d %6d %10.0f %10.1f %12.0f %10.0f %12.0f\n", distance, lod, chunks, cost.triangles, cost.bytes / 1024.0,
+               cost.triangles * chunks, cost.bytes * chunks / 1024.0, full.triangles * chunks);
+    }
+
+    const double MB = 1024.0 * 1024.0;
+    printf("\nDistance %d with LOD:    %10.0f triangles %8.1f MB mesh %8.1f MB voxels\n", renderDistance, lodTriangles, lodBytes / MB, voxelBytes / MB);
+    printf("Distance %d full detail: %10.0f triangles %8.1f MB mesh %8.1f MB voxels\n", renderDistance, fullTriangles, fullBytes / MB, fullVoxelBytes / MB);
+    printf("Distance %d full detail:  %10.0f triangles %8.1f MB mesh %8.1f MB voxels\n", FULL_DETAIL_DISTANCE, oldTriangles, oldBytes / MB, oldVoxelBytes / MB);
+    return 0;
+}
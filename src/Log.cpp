@@ -0,0 +1,161 @@
+#include "Log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+// How often the writer thread drains the rings
+static const int WRITER_INTERVAL_MS = 20;
+
+namespace {
+    struct Line {
+        int64_t time;   // ns, steady_clock
+        Log::Level level;
+        uint32_t length;
+        char text[Log::LINE_BYTES];
+    };
+
+    // Formats straight into a fixed buffer; what doesn't fit is cut off
+    class FixedBuffer : public std::streambuf {
+        public:
+            void reset(char* begin, size_t size) { setp(begin, begin + size); }
+            size_t length() const { return static_cast<size_t>(pptr() - pbase()); }
+    };
+
+    int64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const char* levelName(Log::Level level) {
+        switch (level) {
+            case Log::Trace: return "TRACE";
+            case Log::Debug: return "DEBUG";
+            case Log::Info:  return "INFO ";
+            case Log::Warn:  return "WARN ";
+            case Log::Error: return "ERROR";
+        }
+        return "";
+    }
+}
+
+// Single producer (its thread), single consumer (whoever holds drainMutex)
+struct Log::ThreadRing {
+    std::vector<Line> lines = std::vector<Line>(LINES_PER_THREAD);
+    std::atomic<uint64_t> head{0};    // next line to write
+    std::atomic<uint64_t> tail{0};    // next line to drain
+    std::atomic<uint64_t> dropped{0};
+    Line* current = nullptr;          // being written between beginLine and endLine
+    FixedBuffer buffer;
+    std::ostream stream{&buffer};
+    std::ostream discard{nullptr};    // badbit set, << does nothing
+};
+
+struct Log::Registry {
+    std::mutex mutex;                 // guards rings
+    std::vector<ThreadRing*> rings;
+    std::mutex drainMutex;
+    std::vector<Line> batch;          // reused by drains
+    int64_t start = nowNanos();
+};
+
+Log::Registry& Log::registry() {
+    // Never freed, and the writer is detached: threads may log while statics
+    // are destroyed at exit, and flush still runs from atexit
+    static Registry* instance = [] {
+        Registry* created = new Registry();
+        std::thread(writerLoop).detach();
+        std::atexit(flush);
+        return created;
+    }();
+    return *instance;
+}
+
+Log::ThreadRing& Log::threadRing() {
+    thread_local ThreadRing* ring = nullptr;
+    if (ring == nullptr) {
+        ring = new ThreadRing();
+        Registry& threads = registry();
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        threads.rings.push_back(ring);
+    }
+    return *ring;
+}
+
+std::ostream& Log::beginLine(Level level) {
+    ThreadRing& ring = threadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= LINES_PER_THREAD) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        ring.current = nullptr;
+        return ring.discard;
+    }
+    ring.current = &ring.lines[head & (LINES_PER_THREAD - 1)];
+    ring.current->time = nowNanos();
+    ring.current->level = level;
+    ring.buffer.reset(ring.current->text, LINE_BYTES);
+    ring.stream.clear();
+    return ring.stream;
+}
+
+void Log::endLine() {
+    ThreadRing& ring = threadRing();
+    if (ring.current == nullptr) {
+        return;
+    }
+    ring.current->length = static_cast<uint32_t>(ring.buffer.length());
+    ring.current = nullptr;
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Log::flush() {
+    Registry& threads = registry();
+    std::lock_guard<std::mutex> drainLock(threads.drainMutex);
+    std::vector<Line>& batch = threads.batch;
+    batch.clear();
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        for (ThreadRing* ring : threads.rings) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (uint64_t i = tail; i < head; i++) {
+                batch.push_back(ring->lines[i & (LINES_PER_THREAD - 1)]);
+            }
+            ring->tail.store(head, std::memory_order_release);
+            dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+        }
+    }
+    if (batch.empty() && dropped == 0) {
+        return;
+    }
+
+    // Each ring is in order already, interleave the threads by time
+    std::stable_sort(batch.begin(), batch.end(), [](const Line& a, const Line& b) { return a.time < b.time; });
+    bool wroteErrors = false;
+    for (const Line& line : batch) {
+        FILE* out = line.level >= Warn ? stderr : stdout;
+        wroteErrors |= out == stderr;
+        std::fprintf(out, "%10.3f %s %.*s\n", (line.time - threads.start) / 1e9, levelName(line.level),
+                     static_cast<int>(line.length), line.text);
+    }
+    if (dropped > 0) {
+        std::fprintf(stderr, "Log: dropped %llu lines, rings were full\n", static_cast<unsigned long long>(dropped));
+        wroteErrors = true;
+    }
+    std::fflush(stdout);
+    if (wroteErrors) {
+        std::fflush(stderr);
+    }
+}
+
+void Log::writerLoop() {
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_INTERVAL_MS));
+        flush();
+    }
+}
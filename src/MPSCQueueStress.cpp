@@ -0,0 +1,54 @@
+#include "MPSCQueueStress.hpp"
+#include "MPSCQueue.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define STRESS_ITEMS_PER_PRODUCER 200000
+#define STRESS_QUEUE_CAPACITY 64   // small, so producers keep running into a full queue
+
+int runMPSCQueueStress(int producers) {
+    // Each item is the producer in the high bits and its sequence number in the low ones
+    MPSCQueue<uint64_t> queue(STRESS_QUEUE_CAPACITY);
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < producers; producer++) {
+        threads.emplace_back([&queue, producer] {
+            for (uint64_t i = 0; i < STRESS_ITEMS_PER_PRODUCER; i++) {
+                queue.push(static_cast<uint64_t>(producer) << 32 | i);
+            }
+        });
+    }
+
+    std::vector<uint64_t> expected(producers, 0);   // next sequence number per producer
+    uint64_t total = static_cast<uint64_t>(producers) * STRESS_ITEMS_PER_PRODUCER;
+    uint64_t received = 0, errors = 0;
+    while (received < total) {
+        uint64_t item;
+        if (!queue.tryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        received++;
+        uint64_t producer = item >> 32, sequence = item & 0xffffffffu;
+        if (producer >= expected.size() || sequence != expected[producer]) {
+            if (errors++ < 10) {
+                fprintf(stderr, "item %llu from producer %llu, expected %llu\n", (unsigned long long)sequence,
+                        (unsigned long long)producer, producer < expected.size() ? (unsigned long long)expected[producer] : 0ull);
+            }
+            continue;
+        }
+        expected[producer]++;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t leftover;
+    if (queue.tryPop(leftover)) {
+        fprintf(stderr, "queue still has items after all %llu arrived\n", (unsigned long long)total);
+        errors++;
+    }
+    printf("MPSCQueue stress: %d producers, %llu items, %llu errors\n", producers, (unsigned long long)total, (unsigned long long)errors);
+    return errors == 0 ? 0 : 1;
+}
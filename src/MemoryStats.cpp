@@ -0,0 +1,120 @@
+#include "MemoryStats.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    const size_t MB = 1024 * 1024;
+
+    // current is written by workers through track(), everything else is main thread only
+    std::atomic<long long> current[MemoryStats::CATEGORIES];
+    size_t peak[MemoryStats::CATEGORIES];
+    size_t peakRam = 0, peakVram = 0;
+    size_t chunkCount = 0;
+    ChunkMemory chunkTotal, largestChunk;
+    size_t ramBudget = 0, vramBudget = 0;
+    bool exceeded = false;
+
+    size_t currentBytes(int category) {
+        long long bytes = current[category].load(std::memory_order_relaxed);
+        return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+    }
+}
+
+const char* MemoryStats::name(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Voxels:        return "voxels";
+        case MemoryCategory::ChunkMeshes:   return "chunk cpu meshes";
+        case MemoryCategory::ChunkOther:    return "chunk other";
+        case MemoryCategory::MesherScratch: return "mesher scratch";
+        case MemoryCategory::PendingChunks: return "pending chunks";
+        case MemoryCategory::PooledChunks:  return "pooled chunks";
+        case MemoryCategory::GpuMeshes:     return "gpu meshes";
+        case MemoryCategory::GpuStaging:    return "gpu staging ring";
+        case MemoryCategory::GpuHorizon:    return "gpu horizon";
+        case MemoryCategory::Count:         break;
+    }
+    return "?";
+}
+
+bool MemoryStats::isGpu(MemoryCategory category) {
+    return category == MemoryCategory::GpuMeshes || category == MemoryCategory::GpuStaging || category == MemoryCategory::GpuHorizon;
+}
+
+void MemoryStats::set(MemoryCategory category, size_t bytes) {
+    current[static_cast<int>(category)].store(static_cast<long long>(bytes), std::memory_order_relaxed);
+}
+
+void MemoryStats::track(MemoryCategory category, long long deltaBytes) {
+    current[static_cast<int>(category)].fetch_add(deltaBytes, std::memory_order_relaxed);
+}
+
+void MemoryStats::setChunks(size_t chunks, const ChunkMemory& total, const ChunkMemory& largest) {
+    chunkCount = chunks;
+    chunkTotal = total;
+    largestChunk = largest;
+}
+
+void MemoryStats::endSample() {
+    size_t ram = 0, vram = 0;
+    for (int category = 0; category < CATEGORIES; category++) {
+        size_t bytes = currentBytes(category);
+        peak[category] = std::max(peak[category], bytes);
+        (isGpu(static_cast<MemoryCategory>(category)) ? vram : ram) += bytes;
+    }
+    peakRam = std::max(peakRam, ram);
+    peakVram = std::max(peakVram, vram);
+
+    if (!exceeded && ((ramBudget > 0 && ram > ramBudget) || (vramBudget > 0 && vram > vramBudget))) {
+        exceeded = true;
+        LOG_WARN("Memory budget exceeded: RAM ", ram / MB, "/", ramBudget / MB, " MB, VRAM ", vram / MB, "/", vramBudget / MB, " MB");
+    }
+}
+
+MemoryStats::Snapshot MemoryStats::snapshot() {
+    Snapshot result;
+    result.ramBytes = result.vramBytes = 0;
+    for (int category = 0; category < CATEGORIES; category++) {
+        result.current[category] = currentBytes(category);
+        result.peak[category] = peak[category];
+        (isGpu(static_cast<MemoryCategory>(category)) ? result.vramBytes : result.ramBytes) += result.current[category];
+    }
+    result.peakRamBytes = std::max(peakRam, result.ramBytes);
+    result.peakVramBytes = std::max(peakVram, result.vramBytes);
+    result.chunks = chunkCount;
+    result.chunkTotal = chunkTotal;
+    result.largestChunk = largestChunk;
+    return result;
+}
+
+void MemoryStats::setBudget(size_t ramBytes, size_t vramBytes) {
+    ramBudget = ramBytes;
+    vramBudget = vramBytes;
+}
+
+bool MemoryStats::budgetExceeded() {
+    return exceeded;
+}
+
+void MemoryStats::print() {
+    Snapshot stats = snapshot();
+    printf("memory (KB)              current       peak\n");
+    for (int category = 0; category < CATEGORIES; category++) {
+        printf("  %-20s %10zu %10zu\n", name(static_cast<MemoryCategory>(category)), stats.current[category] / 1024, stats.peak[category] / 1024);
+    }
+    printf("  %-20s %10zu %10zu\n", "total ram", stats.ramBytes / 1024, stats.peakRamBytes / 1024);
+    printf("  %-20s %10zu %10zu\n", "total vram", stats.vramBytes / 1024, stats.peakVramBytes / 1024);
+    if (stats.chunks > 0) {
+        const ChunkMemory& total = stats.chunkTotal;
+        const ChunkMemory& largest = stats.largestChunk;
+        printf("per chunk (bytes)     voxels   cpu mesh      other   gpu mesh\n");
+        printf("  mean %14zu %10zu %10zu %10zu\n", total.voxels / stats.chunks, total.cpuMesh / stats.chunks,
+               total.other / stats.chunks, total.gpuMesh / stats.chunks);
+        printf("  largest %11zu %10zu %10zu %10zu\n", largest.voxels, largest.cpuMesh, largest.other, largest.gpuMesh);
+    }
+    if (ramBudget > 0 || vramBudget > 0) {
+        printf("budget RAM %zu MB, VRAM %zu MB: %s\n", ramBudget / MB, vramBudget / MB, exceeded ? "EXCEEDED" : "ok");
+    }
+    fflush(stdout);
+}
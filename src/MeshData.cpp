@@ -0,0 +1,16 @@
+#include "MeshData.hpp"
+#include "MemoryStats.hpp"
+
+MeshData& MeshData::threadScratch() {
+    thread_local MeshData scratch;
+    return scratch;
+}
+
+void MeshData::trackScratchGrowth() {
+    thread_local size_t counted = 0;
+    size_t bytes = threadScratch().capacityBytes();
+    if (bytes != counted) {
+        MemoryStats::track(MemoryCategory::MesherScratch, static_cast<long long>(bytes) - static_cast<long long>(counted));
+        counted = bytes;
+    }
+}
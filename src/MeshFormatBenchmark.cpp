@@ -0,0 +1,64 @@
+#include "MeshFormatBenchmark.hpp"
+#include "Chunk.hpp"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#define BENCH_CHUNK_SIZE 16
+#define BENCH_GRID 8          // chunks per side
+#define BENCH_ITERATIONS 20   // remeshes of every chunk per format
+
+namespace {
+    struct FormatResult {
+        double faces = 0.0;
+        double bytes = 0.0;
+        double millis = 0.0;
+    };
+
+    FormatResult measure(MeshFormat format, std::vector<std::unique_ptr<Chunk>>& chunks) {
+        Chunk::meshFormat = format;
+        FormatResult result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            for (auto& chunk : chunks) {
+                chunk->generateChunk();
+                if (i == 0) {
+                    result.faces += chunk->meshTriangleCount() / 2;
+                    result.bytes += chunk->meshByteSize();
+                }
+            }
+        }
+        result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    void print(const char* name, const FormatResult& result, size_t chunkCount) {
+        double meshes = static_cast<double>(chunkCount) * BENCH_ITERATIONS;
+        printf("%-13s %8.0f %10.1f %9.1f %13.3f %10.0f %10.1f\n", name, result.faces / chunkCount, result.bytes / result.faces,
+               result.bytes / chunkCount / 1024.0, result.millis / meshes, meshes / (result.millis / 1000.0),
+               result.bytes * BENCH_ITERATIONS / (result.millis / 1000.0) / (1024.0 * 1024.0));
+    }
+}
+
+int runMeshFormatBenchmark() {
+    TextureManager textures;
+    MeshFormat previous = Chunk::meshFormat;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    for (int x = 0; x < BENCH_GRID; x++) {
+        for (int z = 0; z < BENCH_GRID; z++) {
+            glm::vec3 position(x * BENCH_CHUNK_SIZE, 0.0f, z * BENCH_CHUNK_SIZE);
+            chunks.emplace_back(new Chunk(BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, position, nullptr, 0, textures));
+        }
+    }
+
+    FormatResult vertices = measure(MeshFormat::Vertices, chunks);
+    FormatResult records = measure(MeshFormat::FaceRecords, chunks);
+    Chunk::meshFormat = previous;
+
+    printf("%-13s %8s %10s %9s %13s %10s %10s\n", "format", "faces", "bytes/face", "KB/chunk", "mesh ms/chunk", "chunks/s", "MB/s out");
+    print("vertices", vertices, chunks.size());
+    print("face records", records, chunks.size());
+    printf("\nFace records are %.1fx smaller, meshing is %.2fx faster\n", vertices.bytes / records.bytes, vertices.millis / records.millis);
+    return 0;
+}
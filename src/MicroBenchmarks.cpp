@@ -0,0 +1,217 @@
+#include "MicroBenchmarks.hpp"
+#include "MicroBench.hpp"
+#include "Chunk.hpp"
+#include "Game.hpp"
+#include "MPSCQueue.hpp"
+#include "TerrainNoise.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define BENCH_CHUNK_SIZE 16
+#define BENCH_GRID 3            // chunks per side around the one being measured
+#define BENCH_POOL_THREADS 4
+#define BENCH_POOL_TASKS 1000   // tasks per thread pool round trip
+#define BENCH_QUEUE_CAPACITY 1024   // like Game's chunksToAdd
+#define BENCH_QUEUE_ITEMS 4096  // items per producer per contended round
+
+// Private Chunk steps the benchmarks call directly
+class ChunkBenchmarkAccess {
+    public:
+        static void beginMesh(Chunk& chunk) {
+            chunk.mesh = &MeshData::threadScratch();
+            chunk.mesh->clear();
+        }
+        static void addFace(Chunk& chunk, const glm::vec3& pos, Face face) {
+            chunk.addFace(pos, face);
+        }
+};
+
+namespace {
+    // Voxel coordinates cycled through by the lookup benchmarks
+    std::vector<glm::ivec3> interiorVoxels() {
+        std::vector<glm::ivec3> voxels;
+        for (int i = 0; i < 1024; i++) {
+            uint32_t hash = columnHash(i, 7);
+            voxels.push_back(glm::ivec3(1 + hash % (BENCH_CHUNK_SIZE - 2), 1 + (hash >> 8) % (BENCH_CHUNK_SIZE - 2), 1 + (hash >> 16) % (BENCH_CHUNK_SIZE - 2)));
+        }
+        return voxels;
+    }
+
+    // Just outside each side, so every lookup goes to the neighbor chunk
+    std::vector<glm::ivec3> borderVoxels() {
+        std::vector<glm::ivec3> voxels;
+        for (int i = 0; i < BENCH_CHUNK_SIZE; i++) {
+            for (int j = 0; j < BENCH_CHUNK_SIZE; j++) {
+                voxels.push_back(glm::ivec3(-1, i, j));
+                voxels.push_back(glm::ivec3(BENCH_CHUNK_SIZE, i, j));
+                voxels.push_back(glm::ivec3(i, j, -1));
+                voxels.push_back(glm::ivec3(i, j, BENCH_CHUNK_SIZE));
+            }
+        }
+        return voxels;
+    }
+}
+
+int runMicroBenchmarks(const std::string& jsonPath) {
+#ifndef __OPTIMIZE__
+    // Unoptimized numbers say nothing about the code, and diffing them even less
+    std::cerr << "--bench-micro needs an optimized build, use make bench" << std::endl;
+    return 1;
+#endif
+    TextureManager textures;
+    MeshFormat previous = Chunk::meshFormat;
+    Chunk::meshFormat = MeshFormat::Vertices;
+
+    // A small loaded world so neighbor lookups find chunks like in the game.
+    // The game is never initialized and never destroyed: its destructor tears
+    // down GL objects and there is no context.
+    Game& game = *new Game(800, 600, BENCH_GRID);
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    for (int x = -1; x < BENCH_GRID - 1; x++) {
+        for (int z = -1; z < BENCH_GRID - 1; z++) {
+            glm::vec3 position(x * BENCH_CHUNK_SIZE, 0.0f, z * BENCH_CHUNK_SIZE);
+            chunks.emplace_back(new Chunk(BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, BENCH_CHUNK_SIZE, position, &game, 0, textures));
+            game.loadedChunks[{x, z}] = chunks.back().get();
+        }
+    }
+    Chunk& chunk = *game.loadedChunks[{0, 0}];
+
+    microbench::Runner runner;
+    runner.run("Chunk::initChunk", [&] { chunk.initChunk(); });
+    runner.run("Chunk::generateChunk", [&] { chunk.generateChunk(); });
+
+    std::vector<glm::ivec3> interior = interiorVoxels();
+    size_t next = 0;
+    runner.run("Chunk::isVoxelSolid interior", [&] {
+        const glm::ivec3& voxel = interior[next++ % interior.size()];
+        microbench::doNotOptimize(chunk.isVoxelSolid(voxel.x, voxel.y, voxel.z));
+    });
+    std::vector<glm::ivec3> border = borderVoxels();
+    runner.run("Chunk::isVoxelSolid border", [&] {
+        const glm::ivec3& voxel = border[next++ % border.size()];
+        microbench::doNotOptimize(chunk.isVoxelSolid(voxel.x, voxel.y, voxel.z));
+    });
+
+    // Clearing every few thousand faces keeps the mesh in cache like a real chunk's
+    ChunkBenchmarkAccess::beginMesh(chunk);
+    size_t faces = 0;
+    runner.run("Chunk::addFace", [&] {
+        if (++faces % 4096 == 0) {
+            ChunkBenchmarkAccess::beginMesh(chunk);
+        }
+        const glm::ivec3& voxel = interior[faces % interior.size()];
+        ChunkBenchmarkAccess::addFace(chunk, glm::vec3(voxel), static_cast<Face>(faces % 6));
+    });
+    chunk.generateChunk();
+
+    // A hit removes the voxel and remeshes (GL), so the ray crosses a band of air and misses
+    Chunk& rayChunk = *game.loadedChunks[{1, 1}];
+    for (int x = 0; x < BENCH_CHUNK_SIZE; x++) {
+        for (int y = 11; y < BENCH_CHUNK_SIZE; y++) {
+            for (int z = 0; z < BENCH_CHUNK_SIZE; z++) {
+                rayChunk.voxels[x][y][z] = BlockType::Air;
+            }
+        }
+    }
+    glm::vec3 rayOrigin(0.2f, 12.6f, 0.3f);
+    glm::vec3 rayDirection = glm::normalize(glm::vec3(1.0f, 0.1f, 0.9f));
+    glm::ivec3 hitVoxel;
+    runner.run("Game::raycast miss", [&] {
+        microbench::doNotOptimize(game.raycast(rayOrigin, rayDirection, rayChunk, hitVoxel, 64.0f));
+    });
+
+    const siv::PerlinNoise& noise = terrainNoise();
+    double coordinate = 0.0;
+    runner.run("PerlinNoise::noise2D_01", [&] {
+        coordinate += 0.37;
+        microbench::doNotOptimize(noise.noise2D_01(coordinate, coordinate * 0.5));
+    });
+    runner.run("PerlinNoise::noise3D_01", [&] {
+        coordinate += 0.37;
+        microbench::doNotOptimize(noise.noise3D_01(coordinate, coordinate * 0.5, coordinate * 0.25));
+    });
+    runner.run("PerlinNoise::octave2D_01 4 octaves", [&] {
+        coordinate += 0.37;
+        microbench::doNotOptimize(noise.octave2D_01(coordinate, coordinate * 0.5, 4));
+    });
+    runner.run("PerlinNoise::octave3D_01 4 octaves", [&] {
+        coordinate += 0.37;
+        microbench::doNotOptimize(noise.octave3D_01(coordinate, coordinate * 0.5, coordinate * 0.25, 4));
+    });
+    runner.run("sampleSurface", [&] {
+        coordinate += 1.0;
+        microbench::doNotOptimize(sampleSurface(noise, static_cast<int>(coordinate), 17, BENCH_CHUNK_SIZE / 2).height);
+    });
+
+    const BlockType BLOCKS[] = {BlockType::Grass, BlockType::Dirt, BlockType::Stone, BlockType::Sand, BlockType::Wood, BlockType::Leaves};
+    const size_t BLOCK_COUNT = sizeof(BLOCKS) / sizeof(BLOCKS[0]);
+    runner.run("getBlockTextureType", [&] {
+        next++;
+        microbench::doNotOptimize(getBlockTextureType(BLOCKS[next % BLOCK_COUNT], static_cast<Face>(next % 6)));
+    });
+
+    // Enqueue a batch of empty tasks and wait until the workers have run them all
+    ThreadPool pool(BENCH_POOL_THREADS);
+    std::atomic<int> done(0);
+    runner.run("ThreadPool enqueue+run", [&] {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < BENCH_POOL_TASKS; i++) {
+            pool.enqueueTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) < BENCH_POOL_TASKS) {
+            std::this_thread::yield();
+        }
+    }, BENCH_POOL_TASKS);
+
+    // Uncontended: the cost of the sequence number handshake itself
+    MPSCQueue<Chunk*> queue(BENCH_QUEUE_CAPACITY);
+    Chunk* popped = nullptr;
+    runner.run("MPSCQueue push+pop", [&] {
+        queue.push(&chunk);
+        queue.tryPop(popped);
+        microbench::doNotOptimize(popped);
+    });
+
+    // Every pool worker pushes at once while this thread drains, like meshed
+    // chunks arriving at the GL thread
+    runner.run("MPSCQueue contended push+pop", [&] {
+        for (int producer = 0; producer < BENCH_POOL_THREADS; producer++) {
+            pool.enqueueTask([&queue, &chunk] {
+                for (int i = 0; i < BENCH_QUEUE_ITEMS; i++) {
+                    queue.push(&chunk);
+                }
+            });
+        }
+        for (int received = 0; received < BENCH_POOL_THREADS * BENCH_QUEUE_ITEMS;) {
+            if (queue.tryPop(popped)) {
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        microbench::doNotOptimize(popped);
+    }, BENCH_POOL_THREADS * BENCH_QUEUE_ITEMS);
+
+    Chunk::meshFormat = previous;
+    game.loadedChunks.clear();   // the chunks are ours, not the game's
+    if (!runner.writeJson(jsonPath)) {
+        fprintf(stderr, "Couldn't write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    printf("\nWrote %s\n", jsonPath.c_str());
+    return 0;
+}
+
+int compareMicroBenchmarks(const std::string& baselinePath, const std::string& currentPath, double thresholdPercent) {
+    std::vector<microbench::Result> baseline, current;
+    if (!microbench::readJson(baselinePath, baseline) || !microbench::readJson(currentPath, current)) {
+        fprintf(stderr, "Couldn't read %s or %s\n", baselinePath.c_str(), currentPath.c_str());
+        return 2;
+    }
+    int regressions = microbench::compare(baseline, current, thresholdPercent);
+    printf("\n%d regression%s over %.1f%%\n", regressions, regressions == 1 ? "" : "s", thresholdPercent);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+#include "OcclusionBenchmark.hpp"
+#include "OcclusionCuller.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Box {
+        glm::vec3 min, max;
+    };
+
+    struct Scene {
+        std::string name;
+        glm::vec3 eye, target;
+        std::vector<Box> occluders;   // nearest first, like Game::Render hands them over
+        std::vector<Box> chunks;      // bounds to test
+    };
+
+    const float CHUNK = 16.0f;
+    const int GRID = 16;              // chunks per side around the camera
+
+    void addChunkGrid(Scene& scene) {
+        for (int x = -GRID / 2; x < GRID / 2; x++) {
+            for (int z = -GRID / 2; z < GRID / 2; z++) {
+                glm::vec3 min(x * CHUNK, 0.0f, z * CHUNK);
+                scene.chunks.push_back({min, min + glm::vec3(CHUNK)});
+            }
+        }
+    }
+
+    // Flat ground half way up every chunk, camera just above it
+    Scene plains() {
+        Scene scene{"plains", glm::vec3(1.0f, 10.0f, 1.0f), glm::vec3(60.0f, 9.0f, 40.0f), {}, {}};
+        addChunkGrid(scene);
+        for (const Box& chunk : scene.chunks) {
+            scene.occluders.push_back({chunk.min, chunk.min + glm::vec3(CHUNK, 8.0f, CHUNK)});
+        }
+        return scene;
+    }
+
+    // A solid ridge right in front of the camera hides most of the world
+    Scene ridge() {
+        Scene scene{"ridge", glm::vec3(0.0f, 9.0f, 0.0f), glm::vec3(0.0f, 9.0f, 100.0f), {}, {}};
+        addChunkGrid(scene);
+        for (int x = -GRID / 2; x < GRID / 2; x++) {
+            glm::vec3 min(x * CHUNK, 0.0f, 16.0f);
+            scene.occluders.push_back({min, min + glm::vec3(CHUNK, CHUNK, CHUNK)});
+        }
+        return scene;
+    }
+
+    // Walking along a canyon: the walls hide everything off to the sides
+    Scene canyon() {
+        Scene scene{"canyon", glm::vec3(8.0f, 4.0f, -100.0f), glm::vec3(20.0f, 4.0f, 100.0f), {}, {}};
+        addChunkGrid(scene);
+        for (int z = -GRID / 2; z < GRID / 2; z++) {
+            scene.occluders.push_back({glm::vec3(-16.0f, 0.0f, z * CHUNK), glm::vec3(0.0f, CHUNK, (z + 1) * CHUNK)});
+            scene.occluders.push_back({glm::vec3(16.0f, 0.0f, z * CHUNK), glm::vec3(32.0f, CHUNK, (z + 1) * CHUNK)});
+        }
+        return scene;
+    }
+
+    // Standing in a cave: solid rock all around a small pocket
+    Scene cave() {
+        Scene scene{"cave", glm::vec3(8.0f, 8.0f, 8.0f), glm::vec3(40.0f, 6.0f, 30.0f), {}, {}};
+        addChunkGrid(scene);
+        scene.occluders.push_back({glm::vec3(-64.0f, 0.0f, -64.0f), glm::vec3(96.0f, 4.0f, 96.0f)});
+        scene.occluders.push_back({glm::vec3(-64.0f, 12.0f, -64.0f), glm::vec3(96.0f, 16.0f, 96.0f)});
+        scene.occluders.push_back({glm::vec3(-64.0f, 0.0f, -64.0f), glm::vec3(0.0f, 16.0f, 96.0f)});
+        scene.occluders.push_back({glm::vec3(16.0f, 0.0f, -64.0f), glm::vec3(96.0f, 16.0f, 96.0f)});
+        scene.occluders.push_back({glm::vec3(-64.0f, 0.0f, -64.0f), glm::vec3(96.0f, 16.0f, 0.0f)});
+        scene.occluders.push_back({glm::vec3(-64.0f, 0.0f, 16.0f), glm::vec3(96.0f, 16.0f, 96.0f)});
+        return scene;
+    }
+}
+
+int runOcclusionBenchmark() {
+    const int ITERATIONS = 200;
+    std::vector<Scene> scenes = {plains(), ridge(), canyon(), cave()};
+    const size_t threadCounts[] = {1, 2, 4};
+
+    printf("%-8s %7s %9s %9s %10s %10s\n", "scene", "threads", "triangles", "occluded", "raster ms", "test ms");
+    for (const Scene& scene : scenes) {
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+        glm::mat4 view = glm::lookAt(scene.eye, scene.target, glm::vec3(0.0f, 1.0f, 0.0f));
+        for (size_t threads : threadCounts) {
+            OcclusionCuller culler(threads);
+            double rasterMillis = 0.0, testMillis = 0.0;
+            size_t occluded = 0;
+            for (int i = 0; i < ITERATIONS; i++) {
+                auto start = std::chrono::steady_clock::now();
+                culler.beginFrame(projection * view);
+                for (const Box& box : scene.occluders) {
+                    culler.addOccluder(box.min, box.max);
+                }
+                culler.rasterize();
+                auto rasterized = std::chrono::steady_clock::now();
+                occluded = 0;
+                for (const Box& chunk : scene.chunks) {
+                    occluded += culler.testBox(chunk.min, chunk.max) ? 0 : 1;
+                }
+                auto tested = std::chrono::steady_clock::now();
+                rasterMillis += std::chrono::duration<double, std::milli>(rasterized - start).count();
+                testMillis += std::chrono::duration<double, std::milli>(tested - rasterized).count();
+            }
+            printf("%-8s %7zu %9zu %4zu/%-4zu %10.3f %10.3f\n", scene.name.c_str(), threads, culler.triangleCount(),
+                   occluded, scene.chunks.size(), rasterMillis / ITERATIONS, testMillis / ITERATIONS);
+        }
+    }
+    return 0;
+}
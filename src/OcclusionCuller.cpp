@@ -0,0 +1,321 @@
+#include "OcclusionCuller.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OCCLUSION_NEON 1
+#endif
+
+// Vertices closer than this (clip w) are treated as crossing the near plane
+static const float NEAR_W = 0.1f;
+
+// Four pixels of a row at a time. SSE on x86, NEON on Apple Silicon, plain
+// loops anywhere else.
+namespace {
+#if defined(OCCLUSION_SSE)
+    struct Float4 {
+        __m128 v;
+        static Float4 set1(float a) { return {_mm_set1_ps(a)}; }
+        static Float4 ramp() { return {_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)}; }
+        static Float4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+        Float4 operator+(Float4 o) const { return {_mm_add_ps(v, o.v)}; }
+        Float4 operator*(Float4 o) const { return {_mm_mul_ps(v, o.v)}; }
+    };
+    // Lanes where a, b and c are all >= 0 take max(old, z), the rest keep old
+    inline Float4 depthMerge(Float4 a, Float4 b, Float4 c, Float4 old, Float4 z) {
+        __m128 zero = _mm_setzero_ps();
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(a.v, zero), _mm_cmpge_ps(b.v, zero)), _mm_cmpge_ps(c.v, zero));
+        __m128 merged = _mm_max_ps(old.v, z.v);
+        return {_mm_or_ps(_mm_and_ps(inside, merged), _mm_andnot_ps(inside, old.v))};
+    }
+#elif defined(OCCLUSION_NEON)
+    struct Float4 {
+        float32x4_t v;
+        static Float4 set1(float a) { return {vdupq_n_f32(a)}; }
+        static Float4 ramp() { const float r[4] = {0.0f, 1.0f, 2.0f, 3.0f}; return {vld1q_f32(r)}; }
+        static Float4 load(const float* p) { return {vld1q_f32(p)}; }
+        void store(float* p) const { vst1q_f32(p, v); }
+        Float4 operator+(Float4 o) const { return {vaddq_f32(v, o.v)}; }
+        Float4 operator*(Float4 o) const { return {vmulq_f32(v, o.v)}; }
+    };
+    inline Float4 depthMerge(Float4 a, Float4 b, Float4 c, Float4 old, Float4 z) {
+        float32x4_t zero = vdupq_n_f32(0.0f);
+        uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_f32(a.v, zero), vcgeq_f32(b.v, zero)), vcgeq_f32(c.v, zero));
+        return {vbslq_f32(inside, vmaxq_f32(old.v, z.v), old.v)};
+    }
+#else
+    struct Float4 {
+        float v[4];
+        static Float4 set1(float a) { return {{a, a, a, a}}; }
+        static Float4 ramp() { return {{0.0f, 1.0f, 2.0f, 3.0f}}; }
+        static Float4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+        void store(float* p) const { for (int i = 0; i < 4; i++) p[i] = v[i]; }
+        Float4 operator+(Float4 o) const { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = v[i] + o.v[i]; return r; }
+        Float4 operator*(Float4 o) const { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = v[i] * o.v[i]; return r; }
+    };
+    inline Float4 depthMerge(Float4 a, Float4 b, Float4 c, Float4 old, Float4 z) {
+        Float4 r;
+        for (int i = 0; i < 4; i++) {
+            bool inside = a.v[i] >= 0.0f && b.v[i] >= 0.0f && c.v[i] >= 0.0f;
+            r.v[i] = inside ? std::max(old.v[i], z.v[i]) : old.v[i];
+        }
+        return r;
+    }
+#endif
+}
+
+OcclusionCuller::OcclusionCuller(size_t threads) : bands(std::max<size_t>(1, threads)) {
+    int w = WIDTH, h = HEIGHT;
+    while (true) {
+        levels.emplace_back(static_cast<size_t>(w) * h, 0.0f);
+        levelWidth.push_back(w);
+        levelHeight.push_back(h);
+        if (w == 1 && h == 1) {
+            break;
+        }
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    if (bands > 1) {
+        pool.reset(new ThreadPool(bands - 1));
+    }
+}
+
+OcclusionCuller::~OcclusionCuller() {
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection) {
+    this->viewProjection = viewProjection;
+    boxes.clear();
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3& min, const glm::vec3& max) {
+    boxes.push_back(min);
+    boxes.push_back(max);
+}
+
+void OcclusionCuller::addClippedTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    // Cut the triangle at w = NEAR_W, which leaves 0, 1 or 2 triangles
+    // (boxes the camera is standing in or next to still occlude that way)
+    const glm::vec4 in[3] = {a, b, c};
+    glm::vec4 out[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++) {
+        const glm::vec4& current = in[i];
+        const glm::vec4& next = in[(i + 1) % 3];
+        bool currentInside = current.w >= NEAR_W;
+        bool nextInside = next.w >= NEAR_W;
+        if (currentInside) {
+            out[count++] = current;
+        }
+        if (currentInside != nextInside) {
+            float t = (NEAR_W - current.w) / (next.w - current.w);
+            out[count++] = current + (next - current) * t;
+        }
+    }
+    for (int i = 2; i < count; i++) {
+        addTriangle(out[0], out[i - 1], out[i]);
+    }
+}
+
+void OcclusionCuller::addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    Triangle t;
+    const glm::vec4* v[3] = {&a, &b, &c};
+    for (int i = 0; i < 3; i++) {
+        float invW = 1.0f / v[i]->w;
+        t.x[i] = (v[i]->x * invW * 0.5f + 0.5f) * WIDTH;
+        t.y[i] = (v[i]->y * invW * 0.5f + 0.5f) * HEIGHT;
+        t.invW[i] = invW;
+    }
+    // Box faces wind counter-clockwise seen from outside, so back faces come
+    // out negative here. They are always behind a front face of the same box.
+    float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+    if (area < 1e-6f) {
+        return;
+    }
+    t.minX = std::max(0, static_cast<int>(std::floor(std::min({t.x[0], t.x[1], t.x[2]}))));
+    t.maxX = std::min(WIDTH - 1, static_cast<int>(std::ceil(std::max({t.x[0], t.x[1], t.x[2]}))));
+    t.minY = std::max(0, static_cast<int>(std::floor(std::min({t.y[0], t.y[1], t.y[2]}))));
+    t.maxY = std::min(HEIGHT - 1, static_cast<int>(std::ceil(std::max({t.y[0], t.y[1], t.y[2]}))));
+    if (t.minX > t.maxX || t.minY > t.maxY) {
+        return;
+    }
+    triangles.push_back(t);
+}
+
+void OcclusionCuller::setupTriangles() {
+    // Corner i has x from bit 0, y from bit 1, z from bit 2. Faces are
+    // counter-clockwise seen from outside the box.
+    static const int faces[6][4] = {
+        {0, 2, 3, 1}, {4, 5, 7, 6},   // -z, +z
+        {0, 4, 6, 2}, {1, 3, 7, 5},   // -x, +x
+        {0, 1, 5, 4}, {2, 6, 7, 3}    // -y, +y
+    };
+    triangles.clear();
+    for (size_t i = 0; i < boxes.size(); i += 2) {
+        const glm::vec3& min = boxes[i];
+        const glm::vec3& max = boxes[i + 1];
+        glm::vec4 corners[8];
+        for (int c = 0; c < 8; c++) {
+            glm::vec3 p((c & 1) ? max.x : min.x, (c & 2) ? max.y : min.y, (c & 4) ? max.z : min.z);
+            corners[c] = viewProjection * glm::vec4(p, 1.0f);
+        }
+        bool crossesNear = false;
+        for (const glm::vec4& corner : corners) {
+            crossesNear = crossesNear || corner.w < NEAR_W;
+        }
+        for (const auto& face : faces) {
+            if (crossesNear) {
+                addClippedTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+                addClippedTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+            } else {
+                addTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+                addTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeBand(int rowBegin, int rowEnd) {
+    PROFILE_ZONE("OcclusionCuller::rasterizeBand");
+    std::vector<float>& depth = levels[0];
+    std::fill(depth.begin() + rowBegin * WIDTH, depth.begin() + rowEnd * WIDTH, 0.0f);
+    const Float4 ramp = Float4::ramp();
+
+    for (const Triangle& t : triangles) {
+        int minY = std::max(t.minY, rowBegin);
+        int maxY = std::min(t.maxY, rowEnd - 1);
+        if (minY > maxY) {
+            continue;
+        }
+        // Edge i is opposite vertex i: E(x, y) = a*x + b*y + c, positive inside
+        float ea[3], eb[3], ec[3];
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            ea[i] = t.y[j] - t.y[k];
+            eb[i] = t.x[k] - t.x[j];
+            ec[i] = t.x[j] * t.y[k] - t.x[k] * t.y[j];
+        }
+        float area = ec[0] + ec[1] + ec[2];
+        // 1/w as a plane over the screen: sum of E_i / area * invW_i
+        float za = 0.0f, zb = 0.0f, zc = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            za += ea[i] * t.invW[i] / area;
+            zb += eb[i] * t.invW[i] / area;
+            zc += ec[i] * t.invW[i] / area;
+        }
+
+        // Evaluate at the first 4 pixels of each row, then step 4 pixels at a time
+        int startX = t.minX & ~3;
+        Float4 px = Float4::set1(startX + 0.5f) + ramp;
+        Float4 step0 = Float4::set1(ea[0] * 4.0f), step1 = Float4::set1(ea[1] * 4.0f);
+        Float4 step2 = Float4::set1(ea[2] * 4.0f), stepZ = Float4::set1(za * 4.0f);
+        for (int y = minY; y <= maxY; y++) {
+            float py = y + 0.5f;
+            Float4 e0 = Float4::set1(ea[0]) * px + Float4::set1(eb[0] * py + ec[0]);
+            Float4 e1 = Float4::set1(ea[1]) * px + Float4::set1(eb[1] * py + ec[1]);
+            Float4 e2 = Float4::set1(ea[2]) * px + Float4::set1(eb[2] * py + ec[2]);
+            Float4 z = Float4::set1(za) * px + Float4::set1(zb * py + zc);
+            float* row = &depth[y * WIDTH];
+            for (int x = startX; x <= t.maxX; x += 4) {
+                depthMerge(e0, e1, e2, Float4::load(row + x), z).store(row + x);
+                e0 = e0 + step0;
+                e1 = e1 + step1;
+                e2 = e2 + step2;
+                z = z + stepZ;
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid() {
+    for (size_t level = 1; level < levels.size(); level++) {
+        const std::vector<float>& src = levels[level - 1];
+        std::vector<float>& dst = levels[level];
+        int srcW = levelWidth[level - 1], srcH = levelHeight[level - 1];
+        int w = levelWidth[level], h = levelHeight[level];
+        for (int y = 0; y < h; y++) {
+            int y0 = std::min(y * 2, srcH - 1), y1 = std::min(y * 2 + 1, srcH - 1);
+            for (int x = 0; x < w; x++) {
+                int x0 = std::min(x * 2, srcW - 1), x1 = std::min(x * 2 + 1, srcW - 1);
+                dst[y * w + x] = std::min(std::min(src[y0 * srcW + x0], src[y0 * srcW + x1]),
+                                          std::min(src[y1 * srcW + x0], src[y1 * srcW + x1]));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::rasterize() {
+    PROFILE_ZONE("OcclusionCuller::rasterize");
+    setupTriangles();
+
+    int rowsPerBand = (HEIGHT + static_cast<int>(bands) - 1) / static_cast<int>(bands);
+    bandsDone = 0;
+    for (size_t band = 1; band < bands; band++) {
+        int rowBegin = std::min(HEIGHT, static_cast<int>(band) * rowsPerBand);
+        int rowEnd = std::min(HEIGHT, rowBegin + rowsPerBand);
+        pool->enqueueTask([this, rowBegin, rowEnd] {
+            rasterizeBand(rowBegin, rowEnd);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            bandsDone++;
+            doneCondition.notify_one();
+        });
+    }
+    rasterizeBand(0, std::min(HEIGHT, rowsPerBand));
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [this] { return bandsDone == bands - 1; });
+    }
+
+    buildPyramid();
+}
+
+bool OcclusionCuller::testBox(const glm::vec3& min, const glm::vec3& max) const {
+    float minX = WIDTH, minY = HEIGHT, maxX = 0.0f, maxY = 0.0f;
+    float nearest = 0.0f;
+    for (int c = 0; c < 8; c++) {
+        glm::vec3 p((c & 1) ? max.x : min.x, (c & 2) ? max.y : min.y, (c & 4) ? max.z : min.z);
+        glm::vec4 clip = viewProjection * glm::vec4(p, 1.0f);
+        if (clip.w < NEAR_W) {
+            return true;
+        }
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+        float y = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::max(nearest, invW);
+    }
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int x1 = std::min(WIDTH - 1, static_cast<int>(std::floor(maxX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int y1 = std::min(HEIGHT - 1, static_cast<int>(std::floor(maxY)));
+    if (x0 > x1 || y0 > y1) {
+        return true;   // off screen, that's the frustum culler's call
+    }
+
+    // Coarsest level where the rectangle spans at most 4 texels a side
+    size_t level = 0;
+    while (level + 1 < levels.size() && std::max(x1 - x0, y1 - y0) >> level > 3) {
+        level++;
+    }
+    const std::vector<float>& depth = levels[level];
+    int w = levelWidth[level];
+    for (int y = y0 >> level; y <= y1 >> level; y++) {
+        for (int x = x0 >> level; x <= x1 >> level; x++) {
+            // Visible if it's nearer than the farthest occluder in this texel
+            if (nearest >= depth[y * w + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,160 @@
+#include "PagedArena.hpp"
+#include <iostream>
+
+// Compact once free space is this scattered over this many blocks
+static const float COMPACT_FRAGMENTATION = 0.6f;
+static const size_t COMPACT_MIN_BLOCKS = 32;
+// Allocations a compaction pass looks at (and moves at most) per frame
+static const size_t COMPACT_ALLOCATIONS_PER_FRAME = 32;
+
+PagedArena::PagedArena(const char* name, uint32_t pageItems) : pageItems(pageItems), name(name) {
+}
+
+PagedArena::~PagedArena() {
+}
+
+void PagedArena::resetPages(uint32_t pageCount) {
+    pages.reset(pageCount);
+}
+
+void PagedArena::clearAllocations() {
+    allocations.clear();
+    freeHandles.clear();
+    liveCount = 0;
+    compacting = false;
+    compactStuck = false;
+}
+
+PagedArena::Handle PagedArena::allocate(uint32_t itemCount, const glm::vec3& offset) {
+    uint32_t pageCount = pagesFor(itemCount);
+    if (pageCount == 0) {
+        return 0;
+    }
+
+    uint32_t firstPage = pages.allocate(pageCount);
+    if (firstPage == BufferSubAllocator::INVALID_OFFSET) {
+        // Out of contiguous space: grow, maintain() takes care of the
+        // scattered free space over the next frames
+        grow(pageCount);
+        firstPage = pages.allocate(pageCount);
+    }
+    if (firstPage == BufferSubAllocator::INVALID_OFFSET) {
+        std::cerr << name << ": out of space for " << itemCount << " items" << std::endl;
+        return 0;
+    }
+
+    Handle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        allocations.push_back(Allocation());
+        handle = static_cast<Handle>(allocations.size());
+        freeHandles.reserve(allocations.capacity());   // so free never has to grow it
+    }
+    Allocation& allocation = allocations[handle - 1];
+    allocation = {firstPage, pageCount, itemCount, offset, true};
+    writePageTable(allocation);
+    liveCount++;
+    return handle;
+}
+
+void PagedArena::free(Handle handle) {
+    if (handle == 0 || handle > allocations.size() || !allocations[handle - 1].live) {
+        return;
+    }
+    Allocation& allocation = allocations[handle - 1];
+    pages.free(allocation.firstPage, allocation.pageCount);
+    allocation.live = false;
+    freeHandles.push_back(handle);
+    liveCount--;
+    compactStuck = false;
+}
+
+PagedArena::Handle PagedArena::reallocate(Handle handle, uint32_t itemCount, const glm::vec3& offset) {
+    if (handle == 0 || handle > allocations.size() || !allocations[handle - 1].live) {
+        return allocate(itemCount, offset);
+    }
+    Allocation& allocation = allocations[handle - 1];
+    uint32_t pageCount = pagesFor(itemCount);
+    if (pageCount > 0 && pages.resize(allocation.firstPage, allocation.pageCount, pageCount)) {
+        bool newPages = pageCount > allocation.pageCount || allocation.offset != offset;
+        allocation.pageCount = pageCount;
+        allocation.itemCount = itemCount;
+        allocation.offset = offset;
+        if (newPages) {
+            writePageTable(allocation);
+        }
+        inPlaceUpdates++;
+        return handle;
+    }
+
+    // The old contents are about to be overwritten, so moving is just free + allocate
+    free(handle);
+    if (pageCount == 0) {
+        return 0;
+    }
+    relocations++;
+    return allocate(itemCount, offset);
+}
+
+PagedArena::Stats PagedArena::pageStats(size_t pageBytes) const {
+    Stats result;
+    result.bytesInUse = pages.usedUnits() * pageBytes;
+    result.bytesReserved = pages.capacity() * pageBytes;
+    result.vertexFragmentation = pages.fragmentation();
+    result.inPlaceUpdates = inPlaceUpdates;
+    result.relocations = relocations;
+    result.compactions = compactions;
+    return result;
+}
+
+void PagedArena::grow(uint32_t pageCount) {
+    uint32_t capacity = pages.capacity() * 2;
+    while (pages.usedUnits() + pageCount > capacity / 4 * 3) {
+        capacity *= 2;
+    }
+    growBuffers(capacity);
+    pages.grow(capacity);
+}
+
+void PagedArena::maintain() {
+    if (!compacting && !compactStuck && pages.freeBlockCount() > COMPACT_MIN_BLOCKS && pages.fragmentation() > COMPACT_FRAGMENTATION) {
+        compactions++;
+        compacting = true;
+        compactCursor = 0;
+        compactMoved = false;
+    }
+    if (compacting) {
+        compactStep();
+    }
+}
+
+void PagedArena::compactStep() {
+    // First fit hands out the lowest hole that fits, so every move packs
+    // toward the front; the old pages become free space for the next ones
+    for (size_t looked = 0; looked < COMPACT_ALLOCATIONS_PER_FRAME && compactCursor < allocations.size(); looked++) {
+        Allocation& allocation = allocations[compactCursor++];
+        if (!allocation.live) {
+            continue;
+        }
+        uint32_t firstPage = pages.allocate(allocation.pageCount);
+        if (firstPage == BufferSubAllocator::INVALID_OFFSET || firstPage > allocation.firstPage) {
+            pages.free(firstPage, allocation.pageCount);
+            continue;
+        }
+        move(allocation, firstPage);
+        compactMoved = true;
+    }
+    if (compactCursor >= allocations.size()) {
+        compacting = false;
+        compactStuck = !compactMoved;
+    }
+}
+
+void PagedArena::move(Allocation& allocation, uint32_t firstPage) {
+    movePages(allocation.firstPage, firstPage, allocation.pageCount);
+    pages.free(allocation.firstPage, allocation.pageCount);
+    allocation.firstPage = firstPage;
+    writePageTable(allocation);
+}
@@ -0,0 +1,132 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Profiler::ThreadBuffer {
+    std::vector<Event> events = std::vector<Event>(EVENTS_PER_THREAD);
+    // Zones written so far; only the owning thread stores, the exporter loads
+    std::atomic<uint64_t> written{0};
+    uint32_t threadId = 0;
+    std::string name;
+};
+
+struct Profiler::Registry {
+    std::mutex mutex;
+    std::vector<ThreadBuffer*> buffers;
+};
+
+namespace {
+    void writeJsonString(std::ostream& out, const std::string& text) {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+}
+
+Profiler::Registry& Profiler::registry() {
+    // Never freed: worker threads can still end zones while statics are destroyed at exit
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void Profiler::clockStart(int64_t& startTicks, std::chrono::steady_clock::time_point& startTime) {
+    static const int64_t firstTicks = ticks();
+    static const std::chrono::steady_clock::time_point firstTime = std::chrono::steady_clock::now();
+    startTicks = firstTicks;
+    startTime = firstTime;
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    // Registered once per thread, after that recording never locks
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        int64_t startTicks;
+        std::chrono::steady_clock::time_point startTime;
+        clockStart(startTicks, startTime);
+        buffer = new ThreadBuffer();
+        Registry& threads = registry();
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        buffer->threadId = static_cast<uint32_t>(threads.buffers.size());
+        buffer->name = "thread " + std::to_string(buffer->threadId);
+        threads.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index & (EVENTS_PER_THREAD - 1)] = {name, start, end};
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path, double lastSeconds) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Profiler: can't write " << path << std::endl;
+        return false;
+    }
+    int64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+    clockStart(startTicks, startTime);
+    int64_t nowTicks = ticks();
+    double elapsedNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+    double nanosPerTick = nowTicks > startTicks ? elapsedNanos / (nowTicks - startTicks) : 1.0;
+    int64_t cutoff = lastSeconds > 0.0 ? nowTicks - static_cast<int64_t>(lastSeconds * 1e9 / nanosPerTick) : 0;
+
+    Registry& threads = registry();
+    std::lock_guard<std::mutex> lock(threads.mutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    size_t eventCount = 0;
+    std::vector<Event> events;
+    for (ThreadBuffer* buffer : threads.buffers) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer->name);
+        out << "}}";
+        first = false;
+
+        // Copy the ring, then drop whatever its thread may have overwritten meanwhile
+        uint64_t end = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; i++) {
+            events.push_back(buffer->events[i & (EVENTS_PER_THREAD - 1)]);
+        }
+        uint64_t after = buffer->written.load(std::memory_order_acquire);
+        size_t overwritten = after > begin + EVENTS_PER_THREAD ? static_cast<size_t>(after - begin - EVENTS_PER_THREAD) : 0;
+        events.erase(events.begin(), events.begin() + std::min(overwritten, events.size()));
+
+        for (const Event& event : events) {
+            if (event.end < cutoff) {
+                continue;
+            }
+            // Chrome wants microseconds
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << (event.start - startTicks) * nanosPerTick / 1000.0
+                << ",\"dur\":" << (event.end - event.start) * nanosPerTick / 1000.0 << "}";
+            eventCount++;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    std::cout << "Profiler: wrote " << eventCount << " zones to " << path << std::endl;
+    return static_cast<bool>(out);
+}
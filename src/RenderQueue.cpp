@@ -0,0 +1,187 @@
+#include "RenderQueue.hpp"
+#include "ChunkMeshArena.hpp"
+#include "FaceArena.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <iostream>
+
+RenderQueue::RenderQueue() {
+}
+
+RenderQueue::~RenderQueue() {
+}
+
+void RenderQueue::init(GLuint program, GLuint atlasTexture, ChunkMeshArena& arena) {
+    this->arena = &arena;
+    faces = nullptr;
+    initShared(program, atlasTexture);
+}
+
+void RenderQueue::init(GLuint program, GLuint atlasTexture, FaceArena& faces) {
+    this->faces = &faces;
+    arena = nullptr;
+    initShared(program, atlasTexture);
+}
+
+void RenderQueue::initShared(GLuint program, GLuint atlasTexture) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "PerFrame");
+    if (blockIndex == GL_INVALID_INDEX) {
+        std::cerr << "RenderQueue: shader has no PerFrame uniform block" << std::endl;
+    } else {
+        glUniformBlockBinding(program, blockIndex, PER_FRAME_BINDING);
+    }
+    glGenBuffers(1, &perFrameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, perFrameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrame), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, PER_FRAME_BINDING, perFrameUBO);
+
+    if (usesIndirect()) {
+        glGenBuffers(1, &indirectBuffer);
+    }
+
+    // Samplers and filtering never change, set them once
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "blockTexture"), 0);
+    glUniform1i(glGetUniformLocation(program, "chunkOffsets"), PAGE_TABLE_UNIT);
+    glUniform1i(glGetUniformLocation(program, "faceRecords"), FACE_RECORD_UNIT);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
+
+void RenderQueue::shutdown() {
+    if (perFrameUBO != 0) {
+        glDeleteBuffers(1, &perFrameUBO);
+        perFrameUBO = 0;
+    }
+    if (indirectBuffer != 0) {
+        glDeleteBuffers(1, &indirectBuffer);
+        indirectBuffer = 0;
+        indirectCapacity = 0;
+    }
+}
+
+void RenderQueue::reserve(size_t count) {
+    items.reserve(count);
+    commands.reserve(count);
+    arrayCommands.reserve(count);
+    counts.reserve(count);
+    firsts.reserve(count);
+    offsets.reserve(count);
+    baseVertices.reserve(count);
+}
+
+void RenderQueue::submit(const DrawItem& item) {
+    if (item.indexCount > 0) {
+        items.push_back(item);
+    }
+}
+
+// Binds the indirect buffer with room for bytes of commands
+void RenderQueue::reserveIndirect(size_t bytes) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    if (bytes > indirectCapacity) {
+        indirectCapacity = bytes * 2;
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCapacity, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void RenderQueue::drawRun(size_t begin, size_t end) {
+    GLsizei drawCount = static_cast<GLsizei>(end - begin);
+    if (usesIndirect()) {
+        commands.clear();
+        for (size_t i = begin; i < end; i++) {
+            commands.push_back({static_cast<GLuint>(items[i].indexCount), 1, items[i].firstIndex, items[i].baseVertex, 0});
+        }
+        size_t bytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+        reserveIndirect(bytes);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, commands.data());
+        GLExtensions::glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+        for (size_t i = begin; i < end; i++) {
+            counts.push_back(items[i].indexCount);
+            offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(items[i].firstIndex) * sizeof(GLushort)));
+            baseVertices.push_back(items[i].baseVertex);
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(), drawCount, baseVertices.data());
+    }
+}
+
+void RenderQueue::drawFaceRun(size_t begin, size_t end) {
+    GLsizei drawCount = static_cast<GLsizei>(end - begin);
+    if (usesIndirect()) {
+        arrayCommands.clear();
+        for (size_t i = begin; i < end; i++) {
+            arrayCommands.push_back({static_cast<GLuint>(items[i].indexCount), 1, items[i].firstIndex, 0});
+        }
+        size_t bytes = arrayCommands.size() * sizeof(DrawArraysIndirectCommand);
+        reserveIndirect(bytes);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, arrayCommands.data());
+        GLExtensions::glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        counts.clear();
+        firsts.clear();
+        for (size_t i = begin; i < end; i++) {
+            counts.push_back(items[i].indexCount);
+            firsts.push_back(static_cast<GLint>(items[i].firstIndex));
+        }
+        glMultiDrawArrays(GL_TRIANGLES, firsts.data(), counts.data(), drawCount);
+    }
+}
+
+size_t RenderQueue::flush(const PerFrame& perFrame) {
+    PROFILE_ZONE("RenderQueue::flush");
+    glBindBuffer(GL_UNIFORM_BUFFER, perFrameUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PerFrame), &perFrame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, PER_FRAME_BINDING, perFrameUBO);  // another queue may have taken the binding
+
+    std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) {
+        return a.program != b.program ? a.program < b.program : a.texture < b.texture;
+    });
+
+    if (faces != nullptr) {
+        glBindVertexArray(faces->vao());
+        glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, faces->pageTableTexture());
+        glActiveTexture(GL_TEXTURE0 + FACE_RECORD_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, faces->recordTexture());
+    } else {
+        glBindVertexArray(arena->vao());
+        glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, arena->pageTableTexture());
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    size_t drawCalls = 0;
+    size_t runStart = 0;
+    for (size_t i = 0; i <= items.size(); i++) {
+        bool runEnds = i == items.size() || items[i].program != items[runStart].program || items[i].texture != items[runStart].texture;
+        if (!runEnds) {
+            continue;
+        }
+        if (i > runStart) {
+            glUseProgram(items[runStart].program);
+            glBindTexture(GL_TEXTURE_2D, items[runStart].texture);
+            if (faces != nullptr) {
+                drawFaceRun(runStart, i);
+            } else {
+                drawRun(runStart, i);
+            }
+            drawCalls++;
+        }
+        runStart = i;
+    }
+    glBindVertexArray(0);
+
+    items.clear();
+    return drawCalls;
+}
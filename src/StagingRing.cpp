@@ -0,0 +1,204 @@
+#include "StagingRing.hpp"
+#include "GLExtensions.hpp"
+#include <cstring>
+#include <iostream>
+
+static const size_t STAGING_ALIGNMENT = 16;
+
+StagingRing::StagingRing() {
+}
+
+StagingRing::~StagingRing() {
+}
+
+bool StagingRing::init(size_t capacityBytes) {
+    capacity = capacityBytes;
+    if (GLExtensions::bufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        GLExtensions::glBufferStorage(GL_COPY_READ_BUFFER, capacity, nullptr, flags);
+        base = static_cast<char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, capacity, flags));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        if (base != nullptr) {
+            persistent = true;
+            return true;
+        }
+        std::cerr << "StagingRing: persistent mapping failed, using client memory" << std::endl;
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    clientMemory.resize(capacity);
+    base = clientMemory.data();
+    persistent = false;
+    return true;
+}
+
+void StagingRing::shutdown() {
+    for (size_t i = 0; i < fences.size(); i++) {
+        glDeleteSync(fences[i].fence);
+    }
+    fences.clear();
+    if (buffer != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    base = nullptr;
+    clientMemory.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    head = 0;
+    retiredThisFrame = false;
+}
+
+bool StagingRing::reserve(size_t bytes, Region& region) {
+    if (base == nullptr || bytes == 0) {
+        return false;
+    }
+    size_t need = (bytes + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t offset;
+    if (entries.empty()) {
+        if (need > capacity) {
+            return false;
+        }
+        offset = 0;
+    } else {
+        size_t tail = entries.front().offset;
+        if (head > tail) {
+            // Live data in [tail, head): use the end, or wrap to the start
+            if (capacity - head >= need) {
+                offset = head;
+            } else if (tail > need) {
+                offset = 0;
+            } else {
+                return false;
+            }
+        } else {
+            // Already wrapped, live data in [tail, capacity) and [0, head)
+            if (tail - head > need) {
+                offset = head;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    head = offset + need;
+    region.offset = offset;
+    region.size = bytes;
+    region.id = nextId++;
+    entries.push({offset, need, region.id, State::Reserved, 0});
+    return true;
+}
+
+void StagingRing::copyTo(const Region& region, size_t srcOffset, GLenum target, GLintptr dstOffset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (persistent) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, target, region.offset + srcOffset, dstOffset, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    } else {
+        void* dst = glMapBufferRange(target, dstOffset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst != nullptr) {
+            std::memcpy(dst, base + region.offset + srcOffset, size);
+            glUnmapBuffer(target);
+        } else {
+            // Nothing is mapped, so there's nothing to unmap; upload the plain way
+            glBufferSubData(target, dstOffset, size, base + region.offset + srcOffset);
+        }
+    }
+}
+
+void StagingRing::setState(uint64_t id, State state) {
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].id == id) {
+            entries[i].state = state;
+            return;
+        }
+    }
+}
+
+void StagingRing::popFreeEntries() {
+    while (!entries.empty() && entries.front().state == State::Free) {
+        entries.pop();
+    }
+    if (entries.empty()) {
+        head = 0;
+    }
+}
+
+void StagingRing::retire(const Region& region) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (persistent) {
+        setState(region.id, State::Retired);
+        retiredThisFrame = true;
+    } else {
+        // The fallback copy already happened on the CPU
+        setState(region.id, State::Free);
+        popFreeEntries();
+    }
+}
+
+void StagingRing::release(const Region& region) {
+    std::lock_guard<std::mutex> lock(mutex);
+    setState(region.id, State::Free);
+    popFreeEntries();
+}
+
+void StagingRing::fenceFrame() {
+    // The entries remember which fence covers them, so there's no list of
+    // ids per fence to allocate
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!retiredThisFrame) {
+            return;
+        }
+        retiredThisFrame = false;
+        serial = nextFence++;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].state == State::Retired) {
+                entries[i].state = State::Fenced;
+                entries[i].fence = serial;
+            }
+        }
+    }
+    fences.push({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), serial});
+}
+
+void StagingRing::collect() {
+    // Fences signal in order, stop at the first one still pending
+    while (!fences.empty()) {
+        GLenum status = glClientWaitSync(fences.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(fences.front().fence);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].state == State::Fenced && entries[i].fence <= fences.front().serial) {
+                entries[i].state = State::Free;
+            }
+        }
+        popFreeEntries();
+        fences.pop();
+    }
+}
+
+size_t StagingRing::bytesInUse() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].state != State::Free) {
+            bytes += entries[i].size;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,72 @@
+#include "TerrainNoise.hpp"
+#include <glm/glm.hpp>
+
+static uint32_t worldSeed = TERRAIN_SEED;
+
+void setTerrainSeed(uint32_t seed) {
+    worldSeed = seed;
+}
+
+uint32_t terrainSeed() {
+    return worldSeed;
+}
+
+const siv::PerlinNoise& terrainNoise() {
+    static const siv::PerlinNoise noise(worldSeed);
+    return noise;
+}
+
+uint32_t columnHash(int worldX, int worldZ) {
+    // Mixes the seed and both coordinates, then scrambles the bits (murmur3's finalizer)
+    uint32_t hash = worldSeed ^ (static_cast<uint32_t>(worldX) * 0x8da6b343u) ^ (static_cast<uint32_t>(worldZ) * 0xd8163841u);
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+SurfaceSample sampleSurface(const siv::PerlinNoise& perlinNoise, int worldX, int worldZ, int maxHeight) {
+    // Biome noise calculation
+    float biomeFrequency = 0.02f;
+    float biomeAmplitude = 1.0f;
+    float biomePersistence = 0.5f;
+    int biomeOctaves = 4;
+    float biomeNoise = 0.0f;
+    float maxBiomeAmplitude = 0.0f;
+    float currentBiomeFrequency = biomeFrequency;
+    float currentBiomeAmplitude = biomeAmplitude;
+
+    for (int i = 0; i < biomeOctaves; i++) {
+        biomeNoise += perlinNoise.noise2D_01(worldX * currentBiomeFrequency, worldZ * currentBiomeFrequency) * currentBiomeAmplitude;
+        maxBiomeAmplitude += currentBiomeAmplitude;
+        currentBiomeAmplitude *= biomePersistence;
+        currentBiomeFrequency *= 2.0f;
+    }
+
+    biomeNoise /= maxBiomeAmplitude; // Normalize to [0, 1]
+    biomeNoise = biomeNoise * 2.0f - 1.0f; // Map to [-1, 1]
+
+    BiomeType biome = determineBiome(biomeNoise);
+    const BiomeProperties& properties = biomeProperties.at(biome);  // at() never inserts, safe from workers
+
+    // Terrain height calculation
+    float frequency = 0.01f;
+    float amplitude = 80.0f * properties.terrainRoughness;  // Increased amplitude
+    float terrainNoise = 0.0f;
+    float persistence = 0.5f;
+    int octaves = 4;
+
+    float currentAmplitude = amplitude;
+    float currentFrequency = frequency;
+
+    for (int i = 0; i < octaves; i++) {
+        terrainNoise += perlinNoise.noise2D_01(worldX * currentFrequency, worldZ * currentFrequency) * currentAmplitude;
+        currentAmplitude *= persistence;
+        currentFrequency *= 2.0f;
+    }
+
+    terrainNoise = glm::clamp(terrainNoise, 0.0f, (float)(maxHeight - 1));
+    return {biome, static_cast<int>(terrainNoise)};
+}
@@ -1,9 +1,18 @@
 #include "ThreadPool.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 
-ThreadPool::ThreadPool(size_t numThreads) : stop(false) {
+ThreadPool::ThreadPool(size_t numThreads) : stop(false), startNanos(nowNanos()) {
+    depthHistory.reserve(HISTORY_SAMPLES);
+    tasks.resize(INITIAL_QUEUE_CAPACITY);
     for (size_t i = 0; i < numThreads; i++) {
-        workers.emplace_back(&ThreadPool::workerThread, this);
+        workerStats.emplace_back(new WorkerStats());
+    }
+    for (size_t i = 0; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::workerThread, this, i);
     }
 }
 
@@ -18,27 +27,175 @@ ThreadPool::~ThreadPool(){
     }
 }
 
+uint64_t ThreadPool::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ThreadPool::pushTask(Task&& task) {
+    if (taskCount == tasks.size()) {
+        std::vector<Task> grown(tasks.size() * 2);
+        for (size_t i = 0; i < taskCount; i++) {
+            grown[i] = std::move(tasks[(taskHead + i) % tasks.size()]);
+        }
+        tasks.swap(grown);
+        taskHead = 0;
+    }
+    tasks[(taskHead + taskCount) % tasks.size()] = std::move(task);
+    taskCount++;
+}
+
+ThreadPool::Task ThreadPool::popTask() {
+    Task task = std::move(tasks[taskHead]);
+    tasks[taskHead].function = nullptr;   // let go of the captures now
+    taskHead = (taskHead + 1) % tasks.size();
+    taskCount--;
+    return task;
+}
+
+void ThreadPool::sampleDepth(uint64_t now) {
+    if (now - lastDepthSample < static_cast<uint64_t>(DEPTH_SAMPLE_SECONDS * 1e9)) {
+        return;
+    }
+    lastDepthSample = now;
+    DepthSample sample = {(now - startNanos) * 1e-9, taskCount, completed.load(std::memory_order_relaxed)};
+    if (depthHistory.size() < HISTORY_SAMPLES) {
+        depthHistory.push_back(sample);
+    } else {
+        depthHistory[nextDepthSample] = sample;
+    }
+    nextDepthSample = (nextDepthSample + 1) % HISTORY_SAMPLES;
+}
+
 void ThreadPool::enqueueTask(std::function<void()> task) {
     {
         
         std::unique_lock<std::mutex> lock(queueMutex);
-        tasks.push(task);
+        uint64_t now = nowNanos();
+        pushTask({std::move(task), now});
+        enqueued++;
+        peakDepth = std::max(peakDepth, taskCount);
+        sampleDepth(now);
     }
     condition.notify_one();
 }
 
-void ThreadPool::workerThread(){
+void ThreadPool::drain() {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (taskCount > 0) {
+            popTask();
+            dropped++;
+        }
+    }
+    // Only at shutdown, so polling beats a notify after every task
+    while (running.load(std::memory_order_acquire) > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void ThreadPool::workerThread(size_t index){
+    Profiler::setThreadName("pool worker");
+    WorkerStats& stats = *workerStats[index];
     while (true) {
-        std::function<void()> task;
+        Task task;
+        uint64_t waitStart = nowNanos(), start;
         {
             std::unique_lock<std::mutex> lock(queueMutex);
-            condition.wait(lock, [this]{ return stop || !tasks.empty(); });
-            if (stop && tasks.empty()) {
+            condition.wait(lock, [this]{ return stop || taskCount > 0; });
+            if (stop && taskCount == 0) {
                 return;
             }
-            task = std::move(tasks.front());
-            tasks.pop();
+            task = popTask();
+            running.fetch_add(1, std::memory_order_relaxed);
+            start = nowNanos();
+            sampleDepth(start);
         }
-        task();
+        stats.idleNanos.fetch_add(start - waitStart, std::memory_order_relaxed);
+        stats.waitNanos.record(start - task.enqueuedAt);
+        {
+            PROFILE_ZONE("ThreadPool task");
+            task.function();
+        }
+        uint64_t end = nowNanos();
+        stats.runNanos.record(end - start);
+        stats.busyNanos.fetch_add(end - start, std::memory_order_relaxed);
+        stats.tasks.fetch_add(1, std::memory_order_relaxed);
+        completed.fetch_add(1, std::memory_order_relaxed);
+        running.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ThreadPool::Telemetry ThreadPool::telemetry() {
+    Telemetry result;
+    uint64_t now = nowNanos();
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        sampleDepth(now);
+        result.enqueued = enqueued;
+        result.dropped = dropped;
+        result.queueDepth = taskCount;
+        result.peakQueueDepth = peakDepth;
+        // Unroll the ring, oldest first
+        size_t oldest = depthHistory.size() < HISTORY_SAMPLES ? 0 : nextDepthSample;
+        for (size_t i = 0; i < depthHistory.size(); i++) {
+            result.depthHistory.push_back(depthHistory[(oldest + i) % depthHistory.size()]);
+        }
+    }
+    result.uptimeSeconds = (now - startNanos) * 1e-9;
+    result.completed = completed.load(std::memory_order_relaxed);
+
+    double busy = 0.0, idle = 0.0;
+    for (const auto& stats : workerStats) {
+        WorkerTelemetry worker = {stats->tasks.load(std::memory_order_relaxed), stats->busyNanos.load(std::memory_order_relaxed) * 1e-9,
+                                  stats->idleNanos.load(std::memory_order_relaxed) * 1e-9};
+        result.workers.push_back(worker);
+        result.waitNanos.merge(stats->waitNanos);
+        result.runNanos.merge(stats->runNanos);
+        busy += worker.busySeconds;
+        idle += worker.idleSeconds;
     }
-}
\ No newline at end of file
+    result.utilization = busy + idle > 0.0 ? busy / (busy + idle) : 0.0;
+
+    // Completed tasks between the newest sample and the one about a second before it
+    result.tasksPerSecond = 0.0;
+    if (result.depthHistory.size() > 1) {
+        const DepthSample& newest = result.depthHistory.back();
+        size_t first = result.depthHistory.size() - 1;
+        while (first > 0 && newest.seconds - result.depthHistory[first - 1].seconds <= 1.0) {
+            first--;
+        }
+        const DepthSample& oldest = result.depthHistory[first];
+        if (newest.seconds > oldest.seconds) {
+            result.tasksPerSecond = (newest.completed - oldest.completed) / (newest.seconds - oldest.seconds);
+        }
+    }
+    return result;
+}
+
+bool ThreadPool::writeTelemetryJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "ThreadPool: can't write " << path << std::endl;
+        return false;
+    }
+    Telemetry stats = telemetry();
+    out << "{\"uptime_s\":" << stats.uptimeSeconds << ",\"enqueued\":" << stats.enqueued << ",\"completed\":" << stats.completed
+        << ",\"dropped\":" << stats.dropped << ",\"queue_depth\":" << stats.queueDepth << ",\"peak_queue_depth\":" << stats.peakQueueDepth
+        << ",\"tasks_per_second\":" << stats.tasksPerSecond << ",\"utilization\":" << stats.utilization << ",\n\"wait\":";
+    stats.waitNanos.writeJson(out);
+    out << ",\n\"run\":";
+    stats.runNanos.writeJson(out);
+    out << ",\n\"workers\":[";
+    for (size_t i = 0; i < stats.workers.size(); i++) {
+        const WorkerTelemetry& worker = stats.workers[i];
+        out << (i > 0 ? "," : "") << "{\"tasks\":" << worker.tasks << ",\"busy_s\":" << worker.busySeconds
+            << ",\"idle_s\":" << worker.idleSeconds << "}";
+    }
+    out << "],\n\"depth_history\":[";
+    for (size_t i = 0; i < stats.depthHistory.size(); i++) {
+        const DepthSample& sample = stats.depthHistory[i];
+        out << (i > 0 ? "," : "") << "[" << sample.seconds << "," << sample.depth << "," << sample.completed << "]";
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
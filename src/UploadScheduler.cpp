@@ -0,0 +1,61 @@
+#include "UploadScheduler.hpp"
+#include "Chunk.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+
+UploadScheduler::UploadScheduler(float maxMillisPerFrame, size_t maxBytesPerFrame)
+    : maxMillisPerFrame(maxMillisPerFrame), maxBytesPerFrame(maxBytesPerFrame) {
+}
+
+void UploadScheduler::push(Chunk* chunk) {
+    pending.push_back(chunk);
+}
+
+size_t UploadScheduler::pendingBytes() const {
+    size_t bytes = 0;
+    for (const Chunk* chunk : pending) {
+        bytes += chunk->memoryUsage().ram();
+    }
+    return bytes;
+}
+
+size_t UploadScheduler::process(const glm::vec3& cameraPos, std::vector<Chunk*>& uploaded) {
+    PROFILE_ZONE("UploadScheduler::process");
+    frameBytes = 0;
+    if (pending.empty()) {
+        return 0;
+    }
+
+    // Farthest first so the nearest chunks can be popped off the back
+    auto distanceSq = [&cameraPos](const Chunk* chunk) {
+        glm::vec2 center = glm::vec2(chunk->position.x + chunk->sizeX * 0.5f, chunk->position.z + chunk->sizeZ * 0.5f);
+        glm::vec2 delta = center - glm::vec2(cameraPos.x, cameraPos.z);
+        return glm::dot(delta, delta);
+    };
+    std::sort(pending.begin(), pending.end(), [&](const Chunk* a, const Chunk* b) {
+        return distanceSq(a) > distanceSq(b);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    size_t count = 0;
+    while (!pending.empty()) {
+        Chunk* chunk = pending.back();
+        size_t bytes = chunk->meshByteSize();
+        if (count > 0 && frameBytes + bytes > maxBytesPerFrame) {
+            break;
+        }
+
+        chunk->setupMesh();
+        pending.pop_back();
+        uploaded.push_back(chunk);
+        frameBytes += bytes;
+        count++;
+
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= maxMillisPerFrame) {
+            break;
+        }
+    }
+    return count;
+}
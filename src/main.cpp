@@ -1,12 +1,155 @@
 #include "Game.hpp"
+#include "OcclusionBenchmark.hpp"
+#include "LodBenchmark.hpp"
+#include "MeshFormatBenchmark.hpp"
+#include "MicroBenchmarks.hpp"
+#include "MPSCQueueStress.hpp"
+#include "TerrainNoise.hpp"
+#include "Profiler.hpp"
+#include "MemoryStats.hpp"
+#include "ChunkLifecycle.hpp"
+#include "AllocTracker.hpp"
+#include "UploadScheduler.hpp"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
 
-int main() {
+int main(int argc, char** argv) {
 
-    
+    if (argc > 1 && std::string(argv[1]) == "--bench-occlusion") {
+        return runOcclusionBenchmark();
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-mesh-format") {
+        return runMeshFormatBenchmark();
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-micro") {
+        return runMicroBenchmarks(argc > 2 ? argv[2] : "bench.json");
+    }
+    if (argc > 3 && std::string(argv[1]) == "--bench-compare") {
+        return compareMicroBenchmarks(argv[2], argv[3], argc > 4 ? std::atof(argv[4]) : 5.0);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--stress-mpsc") {
+        return runMPSCQueueStress(argc > 2 ? std::max(1, std::atoi(argv[2])) : 8);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-lod") {
+        return runLodBenchmark(argc > 2 ? std::max(1, std::atoi(argv[2])) : DEFAULT_RENDER_DISTANCE);
+    }
 
-    Game game(SCREEN_WIDTH, SCREEN_HEIGHT);
+    int renderDistance = DEFAULT_RENDER_DISTANCE;
+    MeshFormat meshFormat = MeshFormat::Vertices;
+    bool headless = false, scripted = false, seedGiven = false;
+    bool expectNoRenderAllocations = false, expectNoStreamingAllocations = false;
+    int scriptFrames = 0;   // 0 = the whole script
+    float uploadMillis = UPLOAD_BUDGET_MS;
+    size_t uploadBytes = UPLOAD_BUDGET_BYTES;
+    uint32_t seed = TERRAIN_SEED;
+    std::string recordPath;
+    std::string tracePath;
+    std::string poolTelemetryPath;
+    std::string chunkTracePath;
+    CameraScript cameraScript;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--render-distance" && i + 1 < argc) {
+            renderDistance = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--vertex-pulling") {
+            meshFormat = MeshFormat::FaceRecords;
+        } else if (arg == "--headless") {
+            headless = scripted = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                scriptFrames = std::max(1, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--camera-script" && i + 1 < argc) {
+            // Replays a recorded (or hand written) path, in the window unless --headless
+            if (!cameraScript.load(argv[++i])) {
+                return 1;
+            }
+            scripted = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            // Every profiler zone still buffered when the game exits
+            tracePath = argv[++i];
+        } else if (arg == "--pool-telemetry" && i + 1 < argc) {
+            // Thread pool latency histograms, worker time and queue depth, written at exit
+            poolTelemetryPath = argv[++i];
+        } else if (arg == "--chunk-trace" && i + 1 < argc) {
+            // Per stage chunk latencies and the slow chunks' full traces, written at exit
+            chunkTracePath = argv[++i];
+        } else if (arg == "--slow-chunk-ms" && i + 1 < argc) {
+            ChunkLifecycle::setSlowThreshold(std::atof(argv[++i]));
+        } else if (arg == "--alloc-sample" && i + 1 < argc) {
+            // Keeps the call stack of every Nth allocation (needs an ALLOC_TRACKING=1 build)
+            AllocTracker::setSampleInterval(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--expect-no-render-allocs") {
+            // Exit status 1 if Game::Render allocated on any frame after the warmup
+            expectNoRenderAllocations = true;
+        } else if (arg == "--expect-no-streaming-allocs") {
+            // Same for Game::UpdateChunks, the worker threads and glGen/glDelete calls
+            expectNoStreamingAllocations = true;
+        } else if (arg == "--upload-budget-ms" && i + 1 < argc) {
+            // Time mesh uploads may take per frame (0 = no limit)
+            uploadMillis = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--upload-budget-mb" && i + 1 < argc) {
+            // Mesh bytes uploaded per frame, in MB (0 = no limit)
+            uploadBytes = static_cast<size_t>(std::atof(argv[++i]) * 1024 * 1024);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            seedGiven = true;
+        } else if (arg == "--memory-budget" && i + 2 < argc) {
+            // RAM and VRAM in MB (0 = no limit); the exit status is 1 if either was ever exceeded
+            size_t ramMegabytes = std::strtoul(argv[++i], nullptr, 10);
+            size_t vramMegabytes = std::strtoul(argv[++i], nullptr, 10);
+            MemoryStats::setBudget(ramMegabytes * 1024 * 1024, vramMegabytes * 1024 * 1024);
+        }
+    }
+
+    // A replay flies over the world it was recorded in unless told otherwise
+    if (seedGiven) {
+        setTerrainSeed(seed);
+    } else if (scripted) {
+        setTerrainSeed(cameraScript.seed());
+    }
+
+    Game game(SCREEN_WIDTH, SCREEN_HEIGHT, renderDistance, meshFormat);
+    game.setUploadBudget(uploadMillis, uploadBytes);
+    if (scripted) {
+        if (scriptFrames == 0) {
+            scriptFrames = std::max(1, static_cast<int>(cameraScript.duration() * SCRIPT_FPS));
+        }
+        game.playScript(cameraScript, scriptFrames);
+    }
+    if (headless) {
+        game.enableHeadless();
+    }
+    if (!recordPath.empty()) {
+        game.recordPath(recordPath);
+    }
     game.Run();
-    return 0;
+    if (!tracePath.empty()) {
+        Profiler::writeChromeTrace(tracePath);
+    }
+    if (!poolTelemetryPath.empty()) {
+        game.writePoolTelemetry(poolTelemetryPath);
+    }
+    if (!chunkTracePath.empty()) {
+        ChunkLifecycle::writeJson(chunkTracePath);
+    }
+    if ((expectNoRenderAllocations || expectNoStreamingAllocations) && !AllocTracker::enabled()) {
+        std::cerr << "--expect-no-*-allocs needs a build with ALLOC_TRACKING=1" << std::endl;
+        return 1;
+    }
+    if (expectNoRenderAllocations && AllocTracker::steadyRenderAllocations() > 0) {
+        std::cerr << "Game::Render allocated " << AllocTracker::steadyRenderAllocations() << " times after the warmup" << std::endl;
+        return 1;
+    }
+    if (expectNoStreamingAllocations && (AllocTracker::steadyStreamingAllocations() > 0 || AllocTracker::steadyGlObjectCalls() > 0)) {
+        std::cerr << "Chunk streaming allocated " << AllocTracker::steadyStreamingAllocations() << " times and made "
+                  << AllocTracker::steadyGlObjectCalls() << " glGen/glDelete calls after the warmup" << std::endl;
+        return 1;
+    }
+    return MemoryStats::budgetExceeded() ? 1 : 0;
 }